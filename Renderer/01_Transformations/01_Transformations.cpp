@@ -37,9 +37,11 @@
 #include "../../../../Common_3/Game/Interfaces/IScripting.h"
 #include "../../../../Common_3/Utilities/Interfaces/IFileSystem.h"
 #include "../../../../Common_3/Utilities/Interfaces/ILog.h"
+#include "../../../../Common_3/Utilities/Interfaces/IThread.h"
 #include "../../../../Common_3/Utilities/Interfaces/ITime.h"
 
 #include "../../../../Common_3/Utilities/RingBuffer.h"
+#include "../../../../Common_3/Utilities/Threading/Atomics.h"
 
 // Renderer
 #include "../../../../Common_3/Graphics/Interfaces/IGraphics.h"
@@ -54,6 +56,15 @@
 #include "../../../../Common_3/Graphics/FSL/defaults.h"
 #include "./Shaders/FSL/Global.srt.h"
 
+#include "../Shared/CmdStateCache.h"
+#include "../Shared/GpuMemoryTracker.h"
+#include "../Shared/InitTimeline.h"
+#include "../Shared/InputRecorder.h"
+#include "../Shared/Percentiles.h"
+#include "../Shared/PipelineCacheName.h"
+#include "../Shared/ShaderArchive.h"
+#include "../Shared/TraceCapture.h"
+
 /// Demo structures
 struct PlanetInfoStruct
 {
@@ -104,6 +115,7 @@ uint32_t     gSphereIndexCount = 0;
 Pipeline*    pSpherePipeline = NULL;
 VertexLayout gSphereVertexLayout = {};
 uint32_t     gSphereLayoutType = 0;
+uint32_t     gSphereMeshLayoutType = UINT32_MAX; // Layout the current sphere buffers were generated with
 
 Shader*        pSkyBoxDrawShader = NULL;
 Buffer*        pSkyBoxVertexBuffer = NULL;
@@ -115,6 +127,143 @@ DescriptorSet* pDescriptorSetUniforms = { NULL };
 
 Buffer* pUniformBuffer[gDataBufferCount] = { NULL };
 
+// Descriptor array mode: the skybox faces and the per-frame uniforms are reached through arrays in the Persistent set,
+// which is bound once per frame. Draws only push the frame slot (gFrameIds) instead of binding the per-frame set; the
+// skybox picks its face texture out of the array per pixel. Nothing is indexed per draw.
+Shader*   pSphereBindlessShader = NULL;
+Pipeline* pSphereBindlessPipeline = NULL;
+Shader*   pSkyBoxBindlessShader = NULL;
+Pipeline* pSkyBoxBindlessPipeline = NULL;
+bool      gBindlessDescriptors = false;
+uint32_t  gFrameIdsIndex = 0;
+COMPILE_ASSERT(gDataBufferCount == 2); // size of gBindlessUniforms in Global.srt.h
+
+// The skybox pass only changes through the contents of the frame slot's uniform buffer, so it is recorded once per
+// swapchain image and frame slot and resubmitted ahead of the per-frame command buffer. A recording is redone when
+// the pipeline or descriptor mode it used changes, and dropped whenever the swapchain or pipelines go away.
+// The GPU profiler and the trace capture assign their queries per frame, so a prerecorded skybox has no "Draw Skybox"
+// timestamp, pipeline stats or trace range. It is off by default to keep those complete.
+struct PrerecordedCmd
+{
+    CmdPool* pCmdPool;
+    Cmd*     pCmd;
+    Fence*   pLastFence; // ring fence of the last submit that used it
+    uint32_t mGeneration;
+    bool     mBindless;
+};
+
+const uint32_t gMaxPrerecordedImages = 8;
+PrerecordedCmd gSkyboxCmds[gMaxPrerecordedImages][gDataBufferCount] = {};
+uint32_t       gSkyboxCmdGeneration = 1;
+bool           gPrerecordSkybox = false;
+
+// CPU cost of recording the skybox and planet draws, per descriptor mode (0 = SRT sets, 1 = descriptor arrays)
+double               gSceneRecordUSec[2] = {};
+uint32_t             gSceneRecordFrames[2] = {};
+// CPU cost of recording the whole frame, per skybox mode (0 = re-recorded every frame, 1 = prerecorded)
+double               gFrameRecordUSec[2] = {};
+uint32_t             gFrameRecordFrames[2] = {};
+static unsigned char gSceneRecordCharArray[256] = {};
+static bstring       gSceneRecordStats = bfromarr(gSceneRecordCharArray);
+
+// Shader programs resolved through the packed shader archive and the pipeline built from each of them.
+// mBinaryHash is the content hash of the vert/frag binaries the program was built from, a shader reload only
+// rebuilds the programs and pipelines whose binaries the reload server changed.
+struct ShaderProgram
+{
+    const char* pVert;
+    const char* pFrag;
+    Shader**    ppShader;
+    Pipeline**  ppPipeline;
+    const char* pPipelineName;
+    uint64_t    mBinaryHash;
+};
+
+enum
+{
+    SHADER_PROGRAM_SKYBOX,
+    SHADER_PROGRAM_SPHERE,
+    SHADER_PROGRAM_SKYBOX_BINDLESS,
+    SHADER_PROGRAM_SPHERE_BINDLESS,
+    SHADER_PROGRAM_COUNT
+};
+
+ShaderProgram gShaderPrograms[SHADER_PROGRAM_COUNT] = {
+    { "skybox.vert", "skybox.frag", &pSkyBoxDrawShader, &pSkyBoxDrawPipeline, "pSkyBoxDrawPipeline", 0 },
+    { "basic.vert", "basic.frag", &pSphereShader, &pSpherePipeline, "pSpherePipeline", 0 },
+    { "skybox_bindless.vert", "skybox_bindless.frag", &pSkyBoxBindlessShader, &pSkyBoxBindlessPipeline, "pSkyBoxBindlessPipeline", 0 },
+    { "basic_bindless.vert", "basic.frag", &pSphereBindlessShader, &pSphereBindlessPipeline, "pSphereBindlessPipeline", 0 },
+};
+
+// Latency of RELOAD_TYPE_SHADER reloads (Unload -> end of Load), TestReloadShader.lua runs 100 of them
+const uint32_t gMaxShaderReloadSamples = 256;
+float          gShaderReloadMs[gMaxShaderReloadSamples] = {};
+uint32_t       gShaderReloadCount = 0;
+int64_t        gShaderReloadStart = 0;
+bool           gIncrementalShaderReload = true;
+
+// Pipelines of an incremental shader reload are compiled on a background thread. The old pipeline keeps
+// drawing until the new one is ready, the swap happens in Draw() right after the frame fence wait.
+// A job owns copies of every state block addPipeline() reads, so the compile thread touches nothing else.
+struct PipelineCompileJob
+{
+    PipelineDesc        mDesc;
+    VertexLayout        mVertexLayout;
+    RasterizerStateDesc mRasterizerState;
+    DepthStateDesc      mDepthState;
+    TinyImageFormat     mColorFormat;
+    Pipeline*           pPipeline;
+    float               mCompileMs;
+    tfrg_atomic32_t     mDone;
+};
+
+struct PendingPipeline
+{
+    PipelineCompileJob mJob;
+    Shader*            pShader; // Installed together with the pipeline, may be the shader already in use
+    int64_t            mRequestTime;
+    bool               mActive;
+};
+
+PendingPipeline     gPendingPipelines[SHADER_PROGRAM_COUNT] = {};
+PipelineCompileJob* gCompileQueue[SHADER_PROGRAM_COUNT] = {};
+uint32_t            gCompileQueueCount = 0;
+bool                gCompileThreadExit = false;
+Mutex               gCompileMutex;
+ConditionVariable   gCompileCondition;
+ThreadHandle        gCompileThread = {};
+
+// Deferred destruction queue: objects replaced while frames are in flight (reload pipelines and shaders, the
+// sphere buffers, the depth buffer of a resize, ...) are tagged with the frame that retired them and freed once
+// that frame's fence has signaled
+enum RetiredResourceType
+{
+    RETIRED_PIPELINE,
+    RETIRED_SHADER,
+    RETIRED_BUFFER,
+    RETIRED_RENDER_TARGET,
+};
+
+struct RetiredResource
+{
+    void*    pResource;
+    uint32_t mType;
+    uint64_t mFrame;
+};
+
+const uint32_t  gMaxRetiredResources = 32;
+RetiredResource gRetiredResources[gMaxRetiredResources] = {};
+uint32_t        gRetiredResourceCount = 0;
+uint64_t        gFrameCount = 0;
+
+// Hitch of a shader reload as seen by the user: the longest frame from the reload request until one frame after
+// the last pipeline was swapped in
+float    gReloadHitchMs = 0.0f;
+float    gLastReloadHitchMs = 0.0f;
+float    gMaxReloadHitchMs = 0.0f;
+float    gLastReloadSwapMs = 0.0f;
+uint32_t gReloadHitchFrames = 0;
+
 uint32_t     gFrameIndex = 0;
 ProfileToken gGpuProfileToken = PROFILE_INVALID_TOKEN;
 
@@ -128,13 +277,96 @@ UIComponent* pGuiWindow = NULL;
 
 uint32_t gFontID = 0;
 
-QueryPool* pPipelineStatsQueryPool[gDataBufferCount] = {};
+// Pipeline statistics per pass. Results are read back when a pool comes around again, with one pool more than
+// frames in flight that is always after the fence of the frame which wrote it, so readback never waits.
+enum
+{
+    PIPELINE_STATS_PASS_SKYBOX,
+    PIPELINE_STATS_PASS_PLANETS,
+    PIPELINE_STATS_PASS_UI,
+    PIPELINE_STATS_PASS_COUNT
+};
+
+enum
+{
+    PIPELINE_STAT_VS_INVOCATIONS,
+    PIPELINE_STAT_PS_INVOCATIONS,
+    PIPELINE_STAT_C_INVOCATIONS,
+    PIPELINE_STAT_IA_PRIMITIVES,
+    PIPELINE_STAT_C_PRIMITIVES,
+    PIPELINE_STAT_COUNT
+};
+
+#if defined(QUEST_VR)
+// A query inside a multiview render pass occupies one slot per view
+#define PIPELINE_STATS_QUERY_STRIDE 2
+#else
+#define PIPELINE_STATS_QUERY_STRIDE 1
+#endif
+
+const char* gPipelineStatsPassNames[PIPELINE_STATS_PASS_COUNT] = { "Skybox", "Planets", "UI" };
+const char* gPipelineStatNames[PIPELINE_STAT_COUNT] = { "VS invocations", "PS invocations", "Clipper invocations", "IA primitives",
+                                                        "Clipper primitives" };
+
+const uint32_t gPipelineStatsPoolCount = gDataBufferCount + 1;
+QueryPool*     pPipelineStatsQueryPool[gPipelineStatsPoolCount] = {};
+bool           gPipelineStatsPoolUsed[gPipelineStatsPoolCount] = {};
+// First pass with a query in each pool: a prerecorded skybox never begins the skybox query, so it is neither resolved
+// nor read back
+uint32_t       gPipelineStatsPoolFirstPass[gPipelineStatsPoolCount] = {};
+uint32_t       gPipelineStatsPoolIndex = 0;
+
+// Rolling history, the text and graphs are only rebuilt every gPipelineStatsRefreshUSec
+const uint32_t gPipelineStatsHistorySize = 128;
+const int64_t  gPipelineStatsRefreshUSec = 250000;
+float          gPipelineStatsHistory[gPipelineStatsHistorySize][PIPELINE_STATS_PASS_COUNT][PIPELINE_STAT_COUNT] = {};
+uint32_t       gPipelineStatsSampleCount = 0;
+int64_t        gPipelineStatsLastRefresh = 0;
+float          gPipelineStatsPlot[PIPELINE_STATS_PASS_COUNT][gPipelineStatsHistorySize] = {}; // PS invocations, oldest first
+uint32_t       gPipelineStatsPlotCount = 0;
+float2         gPipelineStatsPlotRange[PIPELINE_STATS_PASS_COUNT] = {};
+
+// Shared by every pipeline this sample creates, loaded in Init and written back to disk in Exit
+PipelineCache* pPipelineCache = NULL;
+char           gPipelineCacheName[FS_MAX_PATH] = {};
+bool           gPipelineCacheWarm = false;
+
+// Cold start budget for Init(), see logInitTimeline()
+const float gInitBudgetMs = 300.0f;
+
+// Number of frames recorded by the "Capture Chrome Trace" button
+uint32_t gTraceFrameCount = 60;
+
+// --record-input / --replay-input, every input Update consumes goes through one of these channels
+enum InputChannel
+{
+    INPUT_CHANNEL_UI_FOCUSED,
+    INPUT_CHANNEL_MOVE_X,
+    INPUT_CHANNEL_MOVE_Y,
+    INPUT_CHANNEL_LOOK_X,
+    INPUT_CHANNEL_LOOK_Y,
+    INPUT_CHANNEL_MOVE_UP,
+    INPUT_CHANNEL_RESET_VIEW,
+    INPUT_CHANNEL_TOGGLE_FULLSCREEN,
+    INPUT_CHANNEL_TOGGLE_UI,
+    INPUT_CHANNEL_DUMP_PROFILE,
+    INPUT_CHANNEL_EXIT,
+    INPUT_CHANNEL_COUNT
+};
+
+InputRecordArgs gInputRecordArgs = {};
+InputRecorder   gInputRecorder = {};
 
 const char* pSkyBoxImageFileNames[] = { "Skybox_right1.tex",  "Skybox_left2.tex",  "Skybox_top3.tex",
                                         "Skybox_bottom4.tex", "Skybox_front5.tex", "Skybox_back6.tex" };
 
 FontDrawDesc gFrameTimeDraw;
 
+// Binds issued and skipped by the redundant state filter, the last finished frame is shown under the GPU profile
+CmdStateCounters gCmdStateFrame = {};
+CmdStateCounters gCmdStateLastFrame = {};
+char             gCmdStateText[256] = {};
+
 // Generate sky box vertex buffer
 const float gSkyBoxPoints[] = {
     10.0f,  -10.0f, -10.0f, 6.0f, // -z
@@ -165,12 +397,310 @@ const float gSkyBoxPoints[] = {
 static unsigned char gPipelineStatsCharArray[2048] = {};
 static bstring       gPipelineStats = bfromarr(gPipelineStatsCharArray);
 
+static unsigned char gReloadStatsCharArray[256] = {};
+static bstring       gReloadStats = bfromarr(gReloadStatsCharArray);
+
+static unsigned char gGpuMemoryCharArray[512] = {};
+static bstring       gGpuMemoryText = bfromarr(gGpuMemoryCharArray);
+int64_t              gGpuMemoryLastRefresh = 0;
+
+static void recordPipelineStats(QueryPool* pPool, uint32_t firstPass)
+{
+    float(&sample)[PIPELINE_STATS_PASS_COUNT][PIPELINE_STAT_COUNT] =
+        gPipelineStatsHistory[gPipelineStatsSampleCount % gPipelineStatsHistorySize];
+    for (uint32_t pass = 0; pass < PIPELINE_STATS_PASS_COUNT; ++pass)
+    {
+        QueryData data = {};
+        if (pass >= firstPass)
+            getQueryData(pRenderer, pPool, pass * PIPELINE_STATS_QUERY_STRIDE, &data);
+        sample[pass][PIPELINE_STAT_VS_INVOCATIONS] = (float)data.mPipelineStats.mVSInvocations;
+        sample[pass][PIPELINE_STAT_PS_INVOCATIONS] = (float)data.mPipelineStats.mPSInvocations;
+        sample[pass][PIPELINE_STAT_C_INVOCATIONS] = (float)data.mPipelineStats.mCInvocations;
+        sample[pass][PIPELINE_STAT_IA_PRIMITIVES] = (float)data.mPipelineStats.mIAPrimitives;
+        sample[pass][PIPELINE_STAT_C_PRIMITIVES] = (float)data.mPipelineStats.mCPrimitives;
+    }
+    ++gPipelineStatsSampleCount;
+}
+
+static void refreshPipelineStats()
+{
+    const uint32_t count = min(gPipelineStatsSampleCount, gPipelineStatsHistorySize);
+    const uint32_t oldest = gPipelineStatsSampleCount - count;
+
+    bformat(&gPipelineStats, "\nPipeline Stats (last %u frames, min / avg / max):\n", count);
+    for (uint32_t pass = 0; pass < PIPELINE_STATS_PASS_COUNT; ++pass)
+    {
+        bformata(&gPipelineStats, "%s:\n", gPipelineStatsPassNames[pass]);
+        for (uint32_t stat = 0; stat < PIPELINE_STAT_COUNT; ++stat)
+        {
+            float minValue = FLT_MAX;
+            float maxValue = 0.0f;
+            float total = 0.0f;
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                const float value = gPipelineStatsHistory[(oldest + i) % gPipelineStatsHistorySize][pass][stat];
+                minValue = min(minValue, value);
+                maxValue = max(maxValue, value);
+                total += value;
+            }
+            if (!count)
+                minValue = 0.0f;
+            bformata(&gPipelineStats, "    %-20s %10.0f / %10.0f / %10.0f\n", gPipelineStatNames[stat], minValue,
+                     count ? total / count : 0.0f, maxValue);
+        }
+
+        float maxValue = 1.0f;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            gPipelineStatsPlot[pass][i] = gPipelineStatsHistory[(oldest + i) % gPipelineStatsHistorySize][pass][PIPELINE_STAT_PS_INVOCATIONS];
+            maxValue = max(maxValue, gPipelineStatsPlot[pass][i]);
+        }
+        gPipelineStatsPlotRange[pass] = float2(0.0f, maxValue * 1.1f);
+    }
+    gPipelineStatsPlotCount = count;
+}
+
+static void dumpPipelineStatsCsv(void*)
+{
+    const char* fileName = "01_Transformations_PipelineStats.csv";
+    FileStream  stream = {};
+    if (!fsOpenStreamFromPath(RD_LOG, fileName, FM_WRITE, &stream))
+    {
+        LOGF(LogLevel::eERROR, "Could not open %s for writing", fileName);
+        return;
+    }
+
+    fsPrintToStream(&stream, "frame,pass");
+    for (uint32_t stat = 0; stat < PIPELINE_STAT_COUNT; ++stat)
+        fsPrintToStream(&stream, ",%s", gPipelineStatNames[stat]);
+    fsPrintToStream(&stream, "\n");
+
+    const uint32_t count = min(gPipelineStatsSampleCount, gPipelineStatsHistorySize);
+    const uint32_t oldest = gPipelineStatsSampleCount - count;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        for (uint32_t pass = 0; pass < PIPELINE_STATS_PASS_COUNT; ++pass)
+        {
+            fsPrintToStream(&stream, "%u,%s", oldest + i, gPipelineStatsPassNames[pass]);
+            for (uint32_t stat = 0; stat < PIPELINE_STAT_COUNT; ++stat)
+                fsPrintToStream(&stream, ",%.0f", gPipelineStatsHistory[(oldest + i) % gPipelineStatsHistorySize][pass][stat]);
+            fsPrintToStream(&stream, "\n");
+        }
+    }
+    fsCloseStream(&stream);
+    LOGF(LogLevel::eINFO, "Wrote %u frames of pipeline statistics to %s", count, fileName);
+}
+
 void reloadRequest(void*)
 {
     ReloadDesc reload{ RELOAD_TYPE_SHADER };
     requestReload(&reload);
 }
 
+static void logShaderReloadLatency()
+{
+    const uint32_t count = min(gShaderReloadCount, gMaxShaderReloadSamples);
+    if (!count)
+        return;
+
+    float sorted[gMaxShaderReloadSamples];
+    memcpy(sorted, gShaderReloadMs, count * sizeof(float));
+    const Percentiles p = getPercentiles(sorted, count);
+
+    LOGF(LogLevel::eINFO, "Shader reload latency (%s, %u samples): min %.2f ms, avg %.2f ms, p50 %.2f ms, p95 %.2f ms, p99 %.2f ms, max %.2f ms",
+         gIncrementalShaderReload ? "incremental" : "full", count, p.mMin, p.mAvg, p.mP50, p.mP95, p.mP99, p.mMax);
+}
+
+static void recordShaderReloadLatency()
+{
+    gShaderReloadMs[gShaderReloadCount % gMaxShaderReloadSamples] = (getUSec(true) - gShaderReloadStart) / 1000.0f;
+    if (++gShaderReloadCount % 100 == 0)
+        logShaderReloadLatency();
+}
+
+static void onIncrementalShaderReloadToggled(void*)
+{
+    // Keep the two distributions apart so they can be compared
+    logShaderReloadLatency();
+    gShaderReloadCount = 0;
+}
+
+static uint32_t getPendingPipelineCount()
+{
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < SHADER_PROGRAM_COUNT; ++i)
+        count += gPendingPipelines[i].mActive ? 1 : 0;
+    return count;
+}
+
+static void updateReloadStatsText()
+{
+    bformat(&gReloadStats,
+            "\n"
+            "Shader Reload:\n"
+            "    Hitch:               %.2f ms (max %.2f ms)\n"
+            "    Request to swap:     %.2f ms\n"
+            "    Pipelines compiling: %u\n",
+            gLastReloadHitchMs, gMaxReloadHitchMs, gLastReloadSwapMs, getPendingPipelineCount());
+}
+
+static void onTraceCaptureRequested(void*) { requestTraceCapture(gTraceFrameCount); }
+
+static double getAverageRecordTime(const double* pUSec, const uint32_t* pFrames, uint32_t mode)
+{
+    return pFrames[mode] ? pUSec[mode] / pFrames[mode] : 0.0;
+}
+
+static void updateRecordStatsText()
+{
+    bformat(&gSceneRecordStats,
+            "Scene recording: SRT sets %.2f us, descriptor arrays %.2f us\n"
+            "Frame recording: re-recorded skybox %.2f us, prerecorded skybox %.2f us\n",
+            getAverageRecordTime(gSceneRecordUSec, gSceneRecordFrames, 0), getAverageRecordTime(gSceneRecordUSec, gSceneRecordFrames, 1),
+            getAverageRecordTime(gFrameRecordUSec, gFrameRecordFrames, 0), getAverageRecordTime(gFrameRecordUSec, gFrameRecordFrames, 1));
+}
+
+static void recordSceneRecordTime(bool bindless, int64_t usec)
+{
+    gSceneRecordUSec[bindless] += (double)usec;
+    if (++gSceneRecordFrames[bindless] % 60 == 0)
+        updateRecordStatsText();
+}
+
+static void recordFrameRecordTime(bool prerecorded, int64_t usec)
+{
+    gFrameRecordUSec[prerecorded] += (double)usec;
+    if (++gFrameRecordFrames[prerecorded] % 60 == 0)
+        updateRecordStatsText();
+}
+
+static void logSceneRecordTime()
+{
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        if (gSceneRecordFrames[i])
+            LOGF(LogLevel::eINFO, "Scene recording (%s): %.2f us average over %u frames", i ? "descriptor arrays" : "SRT sets",
+                 getAverageRecordTime(gSceneRecordUSec, gSceneRecordFrames, i), gSceneRecordFrames[i]);
+    }
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        if (gFrameRecordFrames[i])
+            LOGF(LogLevel::eINFO, "Frame recording (%s skybox): %.2f us average over %u frames", i ? "prerecorded" : "re-recorded",
+                 getAverageRecordTime(gFrameRecordUSec, gFrameRecordFrames, i), gFrameRecordFrames[i]);
+    }
+}
+
+static void pipelineCompileThreadFunc(void*)
+{
+    for (;;)
+    {
+        acquireMutex(&gCompileMutex);
+        while (!gCompileQueueCount && !gCompileThreadExit)
+            waitConditionVariable(&gCompileCondition, &gCompileMutex, TIMEOUT_INFINITE);
+        if (!gCompileQueueCount)
+        {
+            releaseMutex(&gCompileMutex);
+            return;
+        }
+        PipelineCompileJob* pJob = gCompileQueue[0];
+        for (uint32_t i = 1; i < gCompileQueueCount; ++i)
+            gCompileQueue[i - 1] = gCompileQueue[i];
+        --gCompileQueueCount;
+        releaseMutex(&gCompileMutex);
+
+        TRACE_SCOPE("Compile Pipeline");
+        int64_t start = getUSec(true);
+        addPipeline(pRenderer, &pJob->mDesc, &pJob->pPipeline);
+        pJob->mCompileMs = (getUSec(true) - start) / 1000.0f;
+        acquireMutex(&gCompileMutex);
+        tfrg_atomic32_store_release(&pJob->mDone, 1);
+        releaseMutex(&gCompileMutex);
+        wakeAllConditionVariable(&gCompileCondition);
+    }
+}
+
+static void queuePipelineCompile(PipelineCompileJob* pJob)
+{
+    pJob->pPipeline = NULL;
+    tfrg_atomic32_store_relaxed(&pJob->mDone, 0);
+    acquireMutex(&gCompileMutex);
+    ASSERT(gCompileQueueCount < SHADER_PROGRAM_COUNT);
+    gCompileQueue[gCompileQueueCount++] = pJob;
+    releaseMutex(&gCompileMutex);
+    wakeAllConditionVariable(&gCompileCondition);
+}
+
+// The frame thread sleeps on the condition variable the compile thread waits on, so every signal wakes both and each
+// re-checks its own condition
+static void waitPipelineCompile(PipelineCompileJob* pJob)
+{
+    acquireMutex(&gCompileMutex);
+    while (!tfrg_atomic32_load_relaxed(&pJob->mDone))
+        waitConditionVariable(&gCompileCondition, &gCompileMutex, TIMEOUT_INFINITE);
+    releaseMutex(&gCompileMutex);
+}
+
+static void freeRetiredResources(bool all)
+{
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < gRetiredResourceCount; ++i)
+    {
+        RetiredResource& retired = gRetiredResources[i];
+        // The fence wait at the top of Draw() guarantees frame (gFrameCount - gDataBufferCount) has completed
+        if (!all && gFrameCount < retired.mFrame + gDataBufferCount)
+        {
+            gRetiredResources[kept++] = retired;
+            continue;
+        }
+        switch (retired.mType)
+        {
+        case RETIRED_PIPELINE:
+            removePipeline(pRenderer, (Pipeline*)retired.pResource);
+            break;
+        case RETIRED_SHADER:
+            removeShader(pRenderer, (Shader*)retired.pResource);
+            break;
+        case RETIRED_BUFFER:
+            gpuMemoryRemoveBuffer((Buffer*)retired.pResource);
+            break;
+        case RETIRED_RENDER_TARGET:
+            gpuMemoryRemoveRenderTarget(pRenderer, (RenderTarget*)retired.pResource);
+            break;
+        }
+    }
+    gRetiredResourceCount = kept;
+}
+
+static void retireResource(RetiredResourceType type, void* pResource)
+{
+    if (!pResource)
+        return;
+    if (gRetiredResourceCount == gMaxRetiredResources)
+    {
+        // Reloads faster than the GPU retires frames, fall back to a drain rather than growing the list
+        waitQueueIdle(pGraphicsQueue);
+        freeRetiredResources(true);
+    }
+    gRetiredResources[gRetiredResourceCount++] = { pResource, (uint32_t)type, gFrameCount };
+    gpuMemoryMarkPendingRelease(pResource);
+}
+
+// Waits for the frames still in flight only, unlike waitQueueIdle() it does not drain anything else on the queue
+static void waitFramesInFlight()
+{
+    Fence*   pFences[gDataBufferCount] = {};
+    uint32_t fenceCount = 0;
+    for (uint32_t i = 0; i < gDataBufferCount; ++i)
+    {
+        FenceStatus fenceStatus;
+        getFenceStatus(pRenderer, gGraphicsCmdRing.pFences[i][0], &fenceStatus);
+        if (fenceStatus == FENCE_STATUS_INCOMPLETE)
+            pFences[fenceCount++] = gGraphicsCmdRing.pFences[i][0];
+    }
+    if (fenceCount)
+        waitForFences(pRenderer, fenceCount, pFences);
+}
+
 const char* gWindowTestScripts[] = { "TestFullScreen.lua", "TestCenteredWindow.lua", "TestNonCenteredWindow.lua", "TestBorderless.lua" };
 
 const char* gReloadServerTestScripts[] = { "TestReloadShader.lua", "TestReloadShaderCapture.lua" };
@@ -411,7 +941,7 @@ static void generate_complex_mesh()
     sphereVbDesc.mDesc.mSize = bufferSize;
     sphereVbDesc.pData = bufferData;
     sphereVbDesc.ppBuffer = &pSphereVertexBuffer;
-    addResource(&sphereVbDesc, nullptr);
+    gpuMemoryAddBuffer(&sphereVbDesc, nullptr, "Sphere Vertex Buffer", GPU_MEMORY_GEOMETRY);
 
     BufferLoadDesc sphereIbDesc = {};
     sphereIbDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_INDEX_BUFFER;
@@ -419,11 +949,13 @@ static void generate_complex_mesh()
     sphereIbDesc.mDesc.mSize = sizeof(indices);
     sphereIbDesc.pData = indices;
     sphereIbDesc.ppBuffer = &pSphereIndexBuffer;
-    addResource(&sphereIbDesc, nullptr);
+    gpuMemoryAddBuffer(&sphereIbDesc, nullptr, "Sphere Index Buffer", GPU_MEMORY_GEOMETRY);
 
     waitForAllResourceLoads();
 
     tf_free(bufferData);
+
+    gSphereMeshLayoutType = gSphereLayoutType;
 }
 
 class Transformations: public IApp
@@ -431,6 +963,15 @@ class Transformations: public IApp
 public:
     bool Init()
     {
+        InitTimeline timeline;
+        initTimelineBegin(&timeline);
+
+        for (int i = 1; i < argc; ++i)
+            inputRecordParseArg(argc, argv, &i, &gInputRecordArgs);
+        if (!initInputRecorder(&gInputRecorder, gInputRecordArgs.mMode, gInputRecordArgs.pFileName, INPUT_CHANNEL_COUNT, 0,
+                               gInputRecordArgs.mFixedDeltaTime))
+            return false;
+
         // window and renderer setup
         RendererDesc settings;
         memset(&settings, 0, sizeof(settings));
@@ -443,13 +984,14 @@ public:
             return false;
         }
         setupGPUConfigurationPlatformParameters(pRenderer, settings.pExtendedSettings);
+        initTimelineMark(&timeline, "renderer");
 
         if (pRenderer->pGpu->mPipelineStatsQueries)
         {
             QueryPoolDesc poolDesc = {};
-            poolDesc.mQueryCount = 3; // The count is 3 due to quest & multi-view use otherwise 2 is enough as we use 2 queries.
+            poolDesc.mQueryCount = PIPELINE_STATS_PASS_COUNT * PIPELINE_STATS_QUERY_STRIDE;
             poolDesc.mType = QUERY_TYPE_PIPELINE_STATISTICS;
-            for (uint32_t i = 0; i < gDataBufferCount; ++i)
+            for (uint32_t i = 0; i < gPipelineStatsPoolCount; ++i)
             {
                 initQueryPool(pRenderer, &poolDesc, &pPipelineStatsQueryPool[i]);
             }
@@ -468,21 +1010,13 @@ public:
         initGpuCmdRing(pRenderer, &cmdRingDesc, &gGraphicsCmdRing);
 
         initSemaphore(pRenderer, &pImageAcquiredSemaphore);
+        initTraceCapture(pRenderer, pGraphicsQueue, GetName());
+        initTimelineMark(&timeline, "queues");
 
         initResourceLoaderInterface(pRenderer);
 
-        RootSignatureDesc rootDesc = {};
-        INIT_RS_DESC(rootDesc, "default.rootsig", "compute.rootsig");
-        initRootSignature(pRenderer, &rootDesc);
-
-        SamplerDesc samplerDesc = { FILTER_LINEAR,
-                                    FILTER_LINEAR,
-                                    MIPMAP_MODE_LINEAR,
-                                    ADDRESS_MODE_CLAMP_TO_EDGE,
-                                    ADDRESS_MODE_CLAMP_TO_EDGE,
-                                    ADDRESS_MODE_CLAMP_TO_EDGE };
-        addSampler(pRenderer, &samplerDesc, &pSkyBoxSampler);
-
+        // Issue every file load first, the loader reads and uploads them while the rest of Init runs.
+        // Nothing below needs the data until the waitForAllResourceLoads() at the end.
         // Loads Skybox Textures
         for (int i = 0; i < 6; ++i)
         {
@@ -491,7 +1025,7 @@ public:
             textureDesc.ppTexture = &pSkyBoxTextures[i];
             // Textures representing color should be stored in SRGB or HDR format
             textureDesc.mCreationFlag = TEXTURE_CREATION_FLAG_SRGB;
-            addResource(&textureDesc, NULL);
+            gpuMemoryAddTexture(&textureDesc, NULL, pSkyBoxImageFileNames[i]);
         }
 
         uint64_t       skyBoxDataSize = 4 * 6 * 6 * sizeof(float);
@@ -501,20 +1035,52 @@ public:
         skyboxVbDesc.mDesc.mSize = skyBoxDataSize;
         skyboxVbDesc.pData = gSkyBoxPoints;
         skyboxVbDesc.ppBuffer = &pSkyBoxVertexBuffer;
-        addResource(&skyboxVbDesc, NULL);
+        gpuMemoryAddBuffer(&skyboxVbDesc, NULL, "Skybox Vertex Buffer", GPU_MEMORY_GEOMETRY);
 
+        // Also viewable as a one element structured buffer for the descriptor array table
         BufferLoadDesc ubDesc = {};
-        ubDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        ubDesc.mDesc.mDescriptors = (DescriptorType)(DESCRIPTOR_TYPE_UNIFORM_BUFFER | DESCRIPTOR_TYPE_BUFFER);
         ubDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
         ubDesc.mDesc.mFlags = BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT;
+        ubDesc.mDesc.mElementCount = 1;
+        ubDesc.mDesc.mStructStride = sizeof(UniformBlock);
         ubDesc.pData = NULL;
         for (uint32_t i = 0; i < gDataBufferCount; ++i)
         {
             ubDesc.mDesc.pName = "UniformBuffer";
             ubDesc.mDesc.mSize = sizeof(UniformBlock);
             ubDesc.ppBuffer = &pUniformBuffer[i];
-            addResource(&ubDesc, NULL);
+            gpuMemoryAddBuffer(&ubDesc, NULL, "Uniform Buffer", GPU_MEMORY_UNIFORM);
         }
+        initTimelineMark(&timeline, "textures (issue)");
+
+        getPipelineCacheName(pRenderer, GetName(), gPipelineCacheName, TF_ARRAY_COUNT(gPipelineCacheName));
+        gPipelineCacheWarm = fsFileExist(RD_PIPELINE_CACHE, gPipelineCacheName);
+        PipelineCacheLoadDesc cacheDesc = {};
+        cacheDesc.pFileName = gPipelineCacheName;
+        loadPipelineCache(pRenderer, &cacheDesc, &pPipelineCache);
+
+        initMutex(&gCompileMutex);
+        initConditionVariable(&gCompileCondition);
+        gCompileThreadExit = false;
+        ThreadDesc compileThreadDesc = {};
+        compileThreadDesc.pFunc = pipelineCompileThreadFunc;
+        strncpy(compileThreadDesc.mThreadName, "PipelineCompile", sizeof(compileThreadDesc.mThreadName));
+        initThread(&compileThreadDesc, &gCompileThread);
+
+        RootSignatureDesc rootDesc = {};
+        INIT_RS_DESC(rootDesc, "default.rootsig", "compute.rootsig");
+        initRootSignature(pRenderer, &rootDesc);
+        gFrameIdsIndex = getDescriptorIndexFromName(pRenderer, "gFrameIds");
+        initTimelineMark(&timeline, "root signature");
+
+        SamplerDesc samplerDesc = { FILTER_LINEAR,
+                                    FILTER_LINEAR,
+                                    MIPMAP_MODE_LINEAR,
+                                    ADDRESS_MODE_CLAMP_TO_EDGE,
+                                    ADDRESS_MODE_CLAMP_TO_EDGE,
+                                    ADDRESS_MODE_CLAMP_TO_EDGE };
+        addSampler(pRenderer, &samplerDesc, &pSkyBoxSampler);
 
         // Load fonts
         FontDesc font = {};
@@ -525,11 +1091,13 @@ public:
         fontRenderDesc.pRenderer = pRenderer;
         if (!initFontSystem(&fontRenderDesc))
             return false; // report?
+        initTimelineMark(&timeline, "fonts");
 
         // Initialize Forge User Interface Rendering
         UserInterfaceDesc uiRenderDesc = {};
         uiRenderDesc.pRenderer = pRenderer;
         initUserInterface(&uiRenderDesc);
+        initTimelineMark(&timeline, "ui");
 
         // Initialize micro profiler and its UI.
         ProfilerDesc profiler = {};
@@ -538,6 +1106,7 @@ public:
 
         // Gpu profiler can only be added after initProfile.
         gGpuProfileToken = initGpuProfiler(pRenderer, pGraphicsQueue, "Graphics");
+        initTimelineMark(&timeline, "profiler");
 
         const uint32_t numScripts = TF_ARRAY_COUNT(gWindowTestScripts);
         LuaScriptDesc  scriptDescs[numScripts] = {};
@@ -548,8 +1117,7 @@ public:
         for (uint32_t i = 0; i < numScriptsFinal; ++i)
             scriptDescs[i].pScriptFileName = mSettings.mBenchmarking ? gWindowTestScripts[i] : gReloadServerTestScripts[i];
         DEFINE_LUA_SCRIPTS(scriptDescs, numScriptsFinal);
-
-        waitForAllResourceLoads();
+        initTimelineMark(&timeline, "scripts");
 
         // Setup planets (Rotation speeds are relative to Earth's, some values randomly given)
         // Sun
@@ -673,14 +1241,36 @@ public:
         AddCustomInputBindings();
         initScreenshotCapturer(pRenderer, pGraphicsQueue, GetName());
         gFrameIndex = 0;
+        initTimelineMark(&timeline, "scene setup");
+
+        waitForAllResourceLoads();
+        initTimelineMark(&timeline, "resource loads");
+        logInitTimeline(&timeline, GetName(), gInitBudgetMs);
 
         return true;
     }
 
     void Exit()
     {
+        exitInputRecorder(&gInputRecorder);
         exitScreenshotCapturer();
 
+        logShaderReloadLatency();
+        logSceneRecordTime();
+        gpuMemoryUpdate();
+        gpuMemoryLogReport(GetName());
+
+        acquireMutex(&gCompileMutex);
+        gCompileThreadExit = true;
+        releaseMutex(&gCompileMutex);
+        wakeAllConditionVariable(&gCompileCondition);
+        joinThread(gCompileThread);
+        exitConditionVariable(&gCompileCondition);
+        exitMutex(&gCompileMutex);
+
+        freeRetiredResources(true);
+        removeShaders();
+
         exitCameraController(pCameraController);
 
         exitUserInterface();
@@ -692,22 +1282,32 @@ public:
 
         for (uint32_t i = 0; i < gDataBufferCount; ++i)
         {
-            removeResource(pUniformBuffer[i]);
-            if (pRenderer->pGpu->mPipelineStatsQueries)
-            {
+            gpuMemoryRemoveBuffer(pUniformBuffer[i]);
+        }
+
+        if (pRenderer->pGpu->mPipelineStatsQueries)
+        {
+            for (uint32_t i = 0; i < gPipelineStatsPoolCount; ++i)
                 exitQueryPool(pRenderer, pPipelineStatsQueryPool[i]);
-            }
         }
 
-        removeResource(pSkyBoxVertexBuffer);
+        gpuMemoryRemoveBuffer(pSkyBoxVertexBuffer);
         removeSampler(pRenderer, pSkyBoxSampler);
 
         for (uint i = 0; i < 6; ++i)
-            removeResource(pSkyBoxTextures[i]);
+            gpuMemoryRemoveTexture(pSkyBoxTextures[i]);
 
+        gpuMemoryCheckLeaks(GetName());
+
+        exitTraceCapture();
         exitGpuCmdRing(pRenderer, &gGraphicsCmdRing);
         exitSemaphore(pRenderer, pImageAcquiredSemaphore);
 
+        PipelineCacheSaveDesc cacheSaveDesc = {};
+        cacheSaveDesc.pFileName = gPipelineCacheName;
+        savePipelineCache(pRenderer, pPipelineCache, &cacheSaveDesc);
+        removePipelineCache(pRenderer, pPipelineCache);
+
         exitRootSignature(pRenderer);
         exitResourceLoaderInterface(pRenderer);
 
@@ -720,6 +1320,16 @@ public:
 
     bool Load(ReloadDesc* pReloadDesc)
     {
+        TRACE_SCOPE("Load");
+        if (gIncrementalShaderReload && pReloadDesc->mType == RELOAD_TYPE_SHADER)
+        {
+            reloadChangedShaders();
+            recordShaderReloadLatency();
+            updateReloadStatsText();
+            gpuMemoryReloadCheckpoint(pReloadDesc->mType);
+            return true;
+        }
+
         if (pReloadDesc->mType & RELOAD_TYPE_SHADER)
         {
             addShaders();
@@ -743,6 +1353,36 @@ public:
             UIWidget* pVLw = uiAddComponentWidget(pGuiWindow, "Vertex Layout", &vertexLayoutWidget, WIDGET_TYPE_SLIDER_UINT);
             uiSetWidgetOnEditedCallback(pVLw, nullptr, reloadRequest);
 
+            CheckboxWidget bindlessCheckbox;
+            bindlessCheckbox.pData = &gBindlessDescriptors;
+            uiAddComponentWidget(pGuiWindow, "Descriptor Arrays", &bindlessCheckbox, WIDGET_TYPE_CHECKBOX);
+
+            static float4     sceneRecordColor = { 1.0f, 1.0f, 1.0f, 1.0f };
+            DynamicTextWidget sceneRecordWidget;
+            sceneRecordWidget.pText = &gSceneRecordStats;
+            sceneRecordWidget.pColor = &sceneRecordColor;
+            uiAddComponentWidget(pGuiWindow, "Scene Recording", &sceneRecordWidget, WIDGET_TYPE_DYNAMIC_TEXT);
+
+            CheckboxWidget prerecordCheckbox;
+            prerecordCheckbox.pData = &gPrerecordSkybox;
+            uiAddComponentWidget(pGuiWindow, "Prerecorded Skybox (untimed)", &prerecordCheckbox, WIDGET_TYPE_CHECKBOX);
+
+            CheckboxWidget incrementalReloadCheckbox;
+            incrementalReloadCheckbox.pData = &gIncrementalShaderReload;
+            UIWidget* pIRw = uiAddComponentWidget(pGuiWindow, "Incremental Shader Reload", &incrementalReloadCheckbox, WIDGET_TYPE_CHECKBOX);
+            uiSetWidgetOnEditedCallback(pIRw, nullptr, onIncrementalShaderReloadToggled);
+
+            SliderUintWidget traceFramesWidget;
+            traceFramesWidget.mMin = 1;
+            traceFramesWidget.mMax = 600;
+            traceFramesWidget.mStep = 1;
+            traceFramesWidget.pData = &gTraceFrameCount;
+            uiAddComponentWidget(pGuiWindow, "Trace Frames", &traceFramesWidget, WIDGET_TYPE_SLIDER_UINT);
+
+            ButtonWidget traceButton;
+            UIWidget*    pTraceButton = uiAddComponentWidget(pGuiWindow, "Capture Chrome Trace", &traceButton, WIDGET_TYPE_BUTTON);
+            uiSetWidgetOnEditedCallback(pTraceButton, nullptr, onTraceCaptureRequested);
+
             if (pRenderer->pGpu->mPipelineStatsQueries)
             {
                 static float4     color = { 1.0f, 1.0f, 1.0f, 1.0f };
@@ -750,12 +1390,45 @@ public:
                 statsWidget.pText = &gPipelineStats;
                 statsWidget.pColor = &color;
                 uiAddComponentWidget(pGuiWindow, "Pipeline Stats", &statsWidget, WIDGET_TYPE_DYNAMIC_TEXT);
+
+                static float2 plotSize = { 300.0f, 60.0f };
+                for (uint32_t pass = 0; pass < PIPELINE_STATS_PASS_COUNT; ++pass)
+                {
+                    static char plotTitles[PIPELINE_STATS_PASS_COUNT][64] = {};
+                    snprintf(plotTitles[pass], sizeof(plotTitles[pass]), "%s PS invocations", gPipelineStatsPassNames[pass]);
+                    PlotLinesWidget plotWidget;
+                    plotWidget.mValues = gPipelineStatsPlot[pass];
+                    plotWidget.mNumValues = &gPipelineStatsPlotCount;
+                    plotWidget.mScale = &gPipelineStatsPlotRange[pass];
+                    plotWidget.mPlotScale = &plotSize;
+                    plotWidget.mTitle = plotTitles[pass];
+                    uiAddComponentWidget(pGuiWindow, plotTitles[pass], &plotWidget, WIDGET_TYPE_PLOT);
+                }
+
+                ButtonWidget dumpButton;
+                UIWidget*    pDumpButton = uiAddComponentWidget(pGuiWindow, "Dump Pipeline Stats CSV", &dumpButton, WIDGET_TYPE_BUTTON);
+                uiSetWidgetOnEditedCallback(pDumpButton, nullptr, dumpPipelineStatsCsv);
             }
 
+            static float4     gpuMemoryColor = { 1.0f, 1.0f, 1.0f, 1.0f };
+            DynamicTextWidget gpuMemoryWidget;
+            gpuMemoryWidget.pText = &gGpuMemoryText;
+            gpuMemoryWidget.pColor = &gpuMemoryColor;
+            uiAddComponentWidget(pGuiWindow, "GPU Memory", &gpuMemoryWidget, WIDGET_TYPE_DYNAMIC_TEXT);
+
+            static float4     reloadStatsColor = { 1.0f, 1.0f, 1.0f, 1.0f };
+            DynamicTextWidget reloadStatsWidget;
+            reloadStatsWidget.pText = &gReloadStats;
+            reloadStatsWidget.pColor = &reloadStatsColor;
+            uiAddComponentWidget(pGuiWindow, "Shader Reload Stats", &reloadStatsWidget, WIDGET_TYPE_DYNAMIC_TEXT);
+
             if (!addSwapChain())
                 return false;
 
-            if (!addDepthBuffer())
+            // A resize created its depth buffer in Unload() already
+            if (pReloadDesc->mType != RELOAD_TYPE_RESIZE)
+                addDepthBuffer();
+            if (!pDepthBuffer)
                 return false;
         }
 
@@ -765,7 +1438,9 @@ public:
             addPipelines();
         }
 
-        prepareDescriptorSets();
+        // Resize only replaces size dependent targets, none of the descriptor sets reference them
+        if (pReloadDesc->mType != RELOAD_TYPE_RESIZE)
+            prepareDescriptorSets();
 
         UserInterfaceLoadDesc uiLoad = {};
         uiLoad.mColorFormat = pSwapChain->ppRenderTargets[0]->mFormat;
@@ -781,12 +1456,54 @@ public:
         fontLoad.mLoadType = pReloadDesc->mType;
         loadFontSystem(&fontLoad);
 
+        if (pReloadDesc->mType == RELOAD_TYPE_SHADER)
+            recordShaderReloadLatency();
+
+        gpuMemoryReloadCheckpoint(pReloadDesc->mType);
+
         return true;
     }
 
     void Unload(ReloadDesc* pReloadDesc)
     {
+        TRACE_SCOPE("Unload");
+        if (pReloadDesc->mType == RELOAD_TYPE_SHADER)
+        {
+            gShaderReloadStart = getUSec(true);
+            gReloadHitchMs = 0.0f;
+            gReloadHitchFrames = 2;
+            // Load() works out which programs changed and tears down only what depends on them
+            if (gIncrementalShaderReload)
+                return;
+        }
+
+        // Resize and fullscreen changes only replace the swapchain and the depth buffer: pipelines, pending compiles
+        // and descriptor sets do not depend on the window size and are kept. The old depth buffer is retired and its
+        // replacement created while the earlier frames are still in flight. Only one swapchain can exist per window
+        // and addSwapChain() can not hand over the old one, so the frames that present to it are waited for before it
+        // is removed.
+        if (pReloadDesc->mType == RELOAD_TYPE_RESIZE)
+        {
+            retireResource(RETIRED_RENDER_TARGET, pDepthBuffer);
+            pDepthBuffer = NULL;
+            addDepthBuffer();
+
+            waitFramesInFlight();
+            unloadFontSystem(pReloadDesc->mType);
+            unloadUserInterface(pReloadDesc->mType);
+
+            removeSkyboxCmds();
+            removeSwapChain(pRenderer, pSwapChain);
+            uiRemoveComponent(pGuiWindow);
+            unloadProfilerUI();
+            return;
+        }
+
+        // Everything is torn down below anyway, so pending compiles are simply finished first
+        finishPipelineCompiles();
         waitQueueIdle(pGraphicsQueue);
+        freeRetiredResources(true);
+        removeSkyboxCmds();
 
         unloadFontSystem(pReloadDesc->mType);
         unloadUserInterface(pReloadDesc->mType);
@@ -794,55 +1511,89 @@ public:
         if (pReloadDesc->mType & (RELOAD_TYPE_SHADER | RELOAD_TYPE_RENDERTARGET))
         {
             removePipelines();
-            removeResource(pSphereVertexBuffer);
-            removeResource(pSphereIndexBuffer);
+            gpuMemoryRemoveBuffer(pSphereVertexBuffer);
+            gpuMemoryRemoveBuffer(pSphereIndexBuffer);
         }
 
         if (pReloadDesc->mType & (RELOAD_TYPE_RESIZE | RELOAD_TYPE_RENDERTARGET))
         {
             removeSwapChain(pRenderer, pSwapChain);
-            removeRenderTarget(pRenderer, pDepthBuffer);
+            gpuMemoryRemoveRenderTarget(pRenderer, pDepthBuffer);
             uiRemoveComponent(pGuiWindow);
             unloadProfilerUI();
         }
 
+        // Shaders survive reloads, addShaders() only recreates the ones whose source changed
         if (pReloadDesc->mType & RELOAD_TYPE_SHADER)
         {
             removeDescriptorSets();
-            removeShaders();
         }
     }
 
     void Update(float deltaTime)
     {
-        if (!uiIsFocused())
+        TRACE_SCOPE("Update");
+        // Measurements keep the real frame time, --fixed-timestep and replays only drive the simulation
+        const float liveDeltaTime = deltaTime;
+        if (!inputRecordBeginFrame(&gInputRecorder, &deltaTime))
+        {
+            // End of the replay, the benchmark run is over
+            requestShutdown();
+        }
+
+        InputRecorder* pRec = &gInputRecorder;
+        if (!inputRecordBits(pRec, INPUT_CHANNEL_UI_FOCUSED, uiIsFocused()))
         {
-            pCameraController->onMove({ inputGetValue(0, CUSTOM_MOVE_X), inputGetValue(0, CUSTOM_MOVE_Y) });
-            pCameraController->onRotate({ inputGetValue(0, CUSTOM_LOOK_X), inputGetValue(0, CUSTOM_LOOK_Y) });
-            pCameraController->onMoveY(inputGetValue(0, CUSTOM_MOVE_UP));
-            if (inputGetValue(0, CUSTOM_RESET_VIEW))
+            pCameraController->onMove({ inputRecordFloat(pRec, INPUT_CHANNEL_MOVE_X, inputGetValue(0, CUSTOM_MOVE_X)),
+                                        inputRecordFloat(pRec, INPUT_CHANNEL_MOVE_Y, inputGetValue(0, CUSTOM_MOVE_Y)) });
+            pCameraController->onRotate({ inputRecordFloat(pRec, INPUT_CHANNEL_LOOK_X, inputGetValue(0, CUSTOM_LOOK_X)),
+                                          inputRecordFloat(pRec, INPUT_CHANNEL_LOOK_Y, inputGetValue(0, CUSTOM_LOOK_Y)) });
+            pCameraController->onMoveY(inputRecordFloat(pRec, INPUT_CHANNEL_MOVE_UP, inputGetValue(0, CUSTOM_MOVE_UP)));
+            if (inputRecordFloat(pRec, INPUT_CHANNEL_RESET_VIEW, inputGetValue(0, CUSTOM_RESET_VIEW)))
             {
                 pCameraController->resetView();
             }
-            if (inputGetValue(0, CUSTOM_TOGGLE_FULLSCREEN))
+            if (inputRecordFloat(pRec, INPUT_CHANNEL_TOGGLE_FULLSCREEN, inputGetValue(0, CUSTOM_TOGGLE_FULLSCREEN)))
             {
                 toggleFullscreen(pWindow);
             }
-            if (inputGetValue(0, CUSTOM_TOGGLE_UI))
+            if (inputRecordFloat(pRec, INPUT_CHANNEL_TOGGLE_UI, inputGetValue(0, CUSTOM_TOGGLE_UI)))
             {
                 uiToggleActive();
             }
-            if (inputGetValue(0, CUSTOM_DUMP_PROFILE))
+            if (inputRecordFloat(pRec, INPUT_CHANNEL_DUMP_PROFILE, inputGetValue(0, CUSTOM_DUMP_PROFILE)))
             {
                 dumpProfileData(GetName());
             }
-            if (inputGetValue(0, CUSTOM_EXIT))
+            if (inputRecordFloat(pRec, INPUT_CHANNEL_EXIT, inputGetValue(0, CUSTOM_EXIT)))
             {
                 requestShutdown();
             }
         }
+        inputRecordEndFrame(pRec);
 
         pCameraController->update(deltaTime);
+
+        const int64_t now = getUSec(false);
+        if (now - gGpuMemoryLastRefresh >= 500000)
+        {
+            gpuMemoryUpdate();
+            gpuMemoryFormatText(pRenderer, &gGpuMemoryText);
+            gGpuMemoryLastRefresh = now;
+        }
+
+        if (gReloadHitchFrames)
+        {
+            gReloadHitchMs = max(gReloadHitchMs, liveDeltaTime * 1000.0f);
+            if (getPendingPipelineCount())
+                gReloadHitchFrames = 2;
+            else if (--gReloadHitchFrames == 0)
+            {
+                gLastReloadHitchMs = gReloadHitchMs;
+                gMaxReloadHitchMs = max(gMaxReloadHitchMs, gReloadHitchMs);
+                updateReloadStatsText();
+            }
+        }
         /************************************************************************/
         // Scene Update
         /************************************************************************/
@@ -902,10 +1653,15 @@ public:
 
     void Draw()
     {
+        TRACE_SCOPE("Draw");
+        // Some APIs recreate the swapchain to toggle vsync, so only the frames presenting to it are waited for, and
+        // the skybox recordings that reference its images are redone
         if ((bool)pSwapChain->mEnableVsync != mSettings.mVSyncEnabled)
         {
-            waitQueueIdle(pGraphicsQueue);
+            TRACE_SCOPE("Toggle VSync");
+            waitFramesInFlight();
             ::toggleVSync(pRenderer, &pSwapChain);
+            ++gSkyboxCmdGeneration;
         }
 
         uint32_t swapchainImageIndex;
@@ -915,10 +1671,17 @@ public:
         GpuCmdRingElement elem = getNextGpuCmdRingElement(&gGraphicsCmdRing, true, 1);
 
         // Stall if CPU is running "gDataBufferCount" frames ahead of GPU
-        FenceStatus fenceStatus;
-        getFenceStatus(pRenderer, elem.pFence, &fenceStatus);
-        if (fenceStatus == FENCE_STATUS_INCOMPLETE)
-            waitForFences(pRenderer, 1, &elem.pFence);
+        {
+            TRACE_SCOPE("Wait Frame Fence");
+            FenceStatus fenceStatus;
+            getFenceStatus(pRenderer, elem.pFence, &fenceStatus);
+            if (fenceStatus == FENCE_STATUS_INCOMPLETE)
+                waitForFences(pRenderer, 1, &elem.pFence);
+        }
+
+        // Frame boundary: nothing recorded yet references the pipelines about to be swapped
+        freeRetiredResources(false);
+        installCompiledPipelines();
 
         // Update uniform buffers
         BufferUpdateDesc viewProjCbv = { pUniformBuffer[gFrameIndex] };
@@ -927,109 +1690,126 @@ public:
         endUpdateResource(&viewProjCbv);
 
         // Reset cmd pool for this frame
+        const int64_t frameRecordStart = getUSec(true);
         resetCmdPool(pRenderer, elem.pCmdPool);
 
+        QueryPool* pStatsPool = pPipelineStatsQueryPool[gPipelineStatsPoolIndex];
         if (pRenderer->pGpu->mPipelineStatsQueries)
         {
-            QueryData data3D = {};
-            QueryData data2D = {};
-            getQueryData(pRenderer, pPipelineStatsQueryPool[gFrameIndex], 0, &data3D);
-            getQueryData(pRenderer, pPipelineStatsQueryPool[gFrameIndex], 1, &data2D);
-            bformat(&gPipelineStats,
-                    "\n"
-                    "Pipeline Stats 3D:\n"
-                    "    VS invocations:      %u\n"
-                    "    PS invocations:      %u\n"
-                    "    Clipper invocations: %u\n"
-                    "    IA primitives:       %u\n"
-                    "    Clipper primitives:  %u\n"
-                    "\n"
-                    "Pipeline Stats 2D UI:\n"
-                    "    VS invocations:      %u\n"
-                    "    PS invocations:      %u\n"
-                    "    Clipper invocations: %u\n"
-                    "    IA primitives:       %u\n"
-                    "    Clipper primitives:  %u\n",
-                    data3D.mPipelineStats.mVSInvocations, data3D.mPipelineStats.mPSInvocations, data3D.mPipelineStats.mCInvocations,
-                    data3D.mPipelineStats.mIAPrimitives, data3D.mPipelineStats.mCPrimitives, data2D.mPipelineStats.mVSInvocations,
-                    data2D.mPipelineStats.mPSInvocations, data2D.mPipelineStats.mCInvocations, data2D.mPipelineStats.mIAPrimitives,
-                    data2D.mPipelineStats.mCPrimitives);
+            if (gPipelineStatsPoolUsed[gPipelineStatsPoolIndex])
+                recordPipelineStats(pStatsPool, gPipelineStatsPoolFirstPass[gPipelineStatsPoolIndex]);
+            gPipelineStatsPoolUsed[gPipelineStatsPoolIndex] = true;
+
+            const int64_t now = getUSec(false);
+            if (now - gPipelineStatsLastRefresh >= gPipelineStatsRefreshUSec)
+            {
+                refreshPipelineStats();
+                gPipelineStatsLastRefresh = now;
+            }
         }
 
         Cmd* cmd = elem.pCmds[0];
         beginCmd(cmd);
+        traceCaptureBeginFrame(cmd);
 
         cmdBeginGpuFrameProfile(cmd, gGpuProfileToken);
         if (pRenderer->pGpu->mPipelineStatsQueries)
         {
-            cmdResetQuery(cmd, pPipelineStatsQueryPool[gFrameIndex], 0, 2);
-            QueryDesc queryDesc = { 0 };
-            cmdBeginQuery(cmd, pPipelineStatsQueryPool[gFrameIndex], &queryDesc);
+            cmdResetQuery(cmd, pStatsPool, 0, PIPELINE_STATS_PASS_COUNT * PIPELINE_STATS_QUERY_STRIDE);
         }
 
+        // The prerecorded skybox command buffer runs first and leaves the target cleared and in render target state
+        const bool     prerecorded = gPrerecordSkybox && swapchainImageIndex < gMaxPrerecordedImages;
+        Cmd*           pSkyboxCmd = prerecorded ? getSkyboxCmd(swapchainImageIndex, pRenderTarget) : NULL;
+        const uint32_t firstStatsPass = prerecorded ? PIPELINE_STATS_PASS_PLANETS : PIPELINE_STATS_PASS_SKYBOX;
+        gPipelineStatsPoolFirstPass[gPipelineStatsPoolIndex] = firstStatsPass;
+
         RenderTargetBarrier barriers[] = {
             { pRenderTarget, RESOURCE_STATE_PRESENT, RESOURCE_STATE_RENDER_TARGET },
         };
-        cmdResourceBarrier(cmd, 0, NULL, 0, NULL, 1, barriers);
+        if (!prerecorded)
+            cmdResourceBarrier(cmd, 0, NULL, 0, NULL, 1, barriers);
 
         cmdBeginGpuTimestampQuery(cmd, gGpuProfileToken, "Draw Skybox/Planets");
+        traceGpuBegin(cmd, "Draw Skybox/Planets");
 
         // simply record the screen cleaning command
+        const LoadActionType  loadAction = prerecorded ? LOAD_ACTION_LOAD : LOAD_ACTION_CLEAR;
         BindRenderTargetsDesc bindRenderTargets = {};
         bindRenderTargets.mRenderTargetCount = 1;
-        bindRenderTargets.mRenderTargets[0] = { pRenderTarget, LOAD_ACTION_CLEAR };
-        bindRenderTargets.mDepthStencil = { pDepthBuffer, LOAD_ACTION_CLEAR };
-        cmdBindRenderTargets(cmd, &bindRenderTargets);
-        cmdSetViewport(cmd, 0.0f, 0.0f, (float)pRenderTarget->mWidth, (float)pRenderTarget->mHeight, 0.0f, 1.0f);
-        cmdSetScissor(cmd, 0, 0, pRenderTarget->mWidth, pRenderTarget->mHeight);
-
-        const uint32_t skyboxVbStride = sizeof(float) * 4;
+        bindRenderTargets.mRenderTargets[0] = { pRenderTarget, loadAction };
+        bindRenderTargets.mDepthStencil = { pDepthBuffer, loadAction };
+        CmdStateCache state;
+        cmdStateBegin(&state, cmd, &gCmdStateFrame);
+        cmdStateBindRenderTargets(&state, &bindRenderTargets);
+        cmdStateSetViewport(&state, 0.0f, 0.0f, (float)pRenderTarget->mWidth, (float)pRenderTarget->mHeight, 0.0f, 1.0f);
+        cmdStateSetScissor(&state, 0, 0, pRenderTarget->mWidth, pRenderTarget->mHeight);
+
+        const bool    bindless = gBindlessDescriptors;
+        Pipeline*     pPlanetPipeline = bindless ? pSphereBindlessPipeline : pSpherePipeline;
+        const int64_t sceneRecordStart = getUSec(true);
         // draw skybox
-        cmdBeginGpuTimestampQuery(cmd, gGpuProfileToken, "Draw Skybox");
-        cmdSetViewport(cmd, 0.0f, 0.0f, (float)pRenderTarget->mWidth, (float)pRenderTarget->mHeight, 1.0f, 1.0f);
-        cmdBindPipeline(cmd, pSkyBoxDrawPipeline);
-        cmdBindDescriptorSet(cmd, 0, pDescriptorSetTexture);
-        cmdBindDescriptorSet(cmd, gFrameIndex, pDescriptorSetUniforms);
-        cmdBindVertexBuffer(cmd, 1, &pSkyBoxVertexBuffer, &skyboxVbStride, NULL);
-        cmdDraw(cmd, 36, 0);
-        cmdSetViewport(cmd, 0.0f, 0.0f, (float)pRenderTarget->mWidth, (float)pRenderTarget->mHeight, 0.0f, 1.0f);
-        cmdEndGpuTimestampQuery(cmd, gGpuProfileToken);
+        if (!prerecorded)
+        {
+            cmdBeginGpuTimestampQuery(cmd, gGpuProfileToken, "Draw Skybox");
+            traceGpuBegin(cmd, "Draw Skybox");
+            beginPipelineStatsPass(cmd, pStatsPool, PIPELINE_STATS_PASS_SKYBOX);
+            drawSkybox(&state, pRenderTarget, bindless);
+            endPipelineStatsPass(cmd, pStatsPool, PIPELINE_STATS_PASS_SKYBOX);
+            traceGpuEnd(cmd);
+            cmdEndGpuTimestampQuery(cmd, gGpuProfileToken);
+        }
 
         cmdBeginGpuTimestampQuery(cmd, gGpuProfileToken, "Draw Planets");
-        cmdBindPipeline(cmd, pSpherePipeline);
-        cmdBindVertexBuffer(cmd, 1, &pSphereVertexBuffer, &gSphereVertexLayout.mBindings[0].mStride, nullptr);
-        cmdBindIndexBuffer(cmd, pSphereIndexBuffer, INDEX_TYPE_UINT16, 0);
-        cmdDrawIndexedInstanced(cmd, gSphereIndexCount, 0, gNumPlanets, 0, 0);
+        traceGpuBegin(cmd, "Draw Planets");
+        beginPipelineStatsPass(cmd, pStatsPool, PIPELINE_STATS_PASS_PLANETS);
+        // NULL while the pipeline for a new vertex layout is still compiling
+        if (pPlanetPipeline)
+        {
+            // Bound again here: with a prerecorded skybox nothing else in this command buffer binds them
+            cmdStateBindPipeline(&state, pPlanetPipeline);
+            cmdStateBindDescriptorSet(&state, CMD_STATE_SET_PERSISTENT, 0, pDescriptorSetTexture);
+            if (bindless)
+                cmdBindPushConstants(cmd, gFrameIdsIndex, &gFrameIndex);
+            else
+                cmdStateBindDescriptorSet(&state, CMD_STATE_SET_PER_FRAME, gFrameIndex, pDescriptorSetUniforms);
+            cmdStateBindVertexBuffer(&state, 1, &pSphereVertexBuffer, &gSphereVertexLayout.mBindings[0].mStride, nullptr);
+            cmdStateBindIndexBuffer(&state, pSphereIndexBuffer, INDEX_TYPE_UINT16, 0);
+            cmdStateDrawIndexedInstanced(&state, gSphereIndexCount, 0, gNumPlanets, 0, 0);
+        }
+        endPipelineStatsPass(cmd, pStatsPool, PIPELINE_STATS_PASS_PLANETS);
+        traceGpuEnd(cmd);
         cmdEndGpuTimestampQuery(cmd, gGpuProfileToken);
+        recordSceneRecordTime(bindless, getUSec(true) - sceneRecordStart);
 
+        traceGpuEnd(cmd); // Draw Skybox/Planets
         cmdEndGpuTimestampQuery(cmd, gGpuProfileToken); // Draw Skybox/Planets
         cmdBindRenderTargets(cmd, NULL);
 
-        if (pRenderer->pGpu->mPipelineStatsQueries)
-        {
-            QueryDesc queryDesc = { 0 };
-            cmdEndQuery(cmd, pPipelineStatsQueryPool[gFrameIndex], &queryDesc);
-
-            queryDesc = { 1 };
-            cmdBeginQuery(cmd, pPipelineStatsQueryPool[gFrameIndex], &queryDesc);
-        }
-
         cmdBeginGpuTimestampQuery(cmd, gGpuProfileToken, "Draw UI");
+        traceGpuBegin(cmd, "Draw UI");
 
         bindRenderTargets = {};
         bindRenderTargets.mRenderTargetCount = 1;
         bindRenderTargets.mRenderTargets[0] = { pRenderTarget, LOAD_ACTION_LOAD };
         bindRenderTargets.mDepthStencil = { NULL, LOAD_ACTION_DONTCARE };
         cmdBindRenderTargets(cmd, &bindRenderTargets);
+        beginPipelineStatsPass(cmd, pStatsPool, PIPELINE_STATS_PASS_UI);
 
         gFrameTimeDraw.mFontColor = 0xff00ffff;
         gFrameTimeDraw.mFontSize = 18.0f;
         gFrameTimeDraw.mFontID = gFontID;
         float2 txtSizePx = cmdDrawCpuProfile(cmd, float2(8.f, 15.f), &gFrameTimeDraw);
-        cmdDrawGpuProfile(cmd, float2(8.f, txtSizePx.y + 75.f), gGpuProfileToken, &gFrameTimeDraw);
+        float2 gpuSizePx = cmdDrawGpuProfile(cmd, float2(8.f, txtSizePx.y + 75.f), gGpuProfileToken, &gFrameTimeDraw);
+
+        cmdStateFormatCounters(&gCmdStateLastFrame, gCmdStateText, sizeof(gCmdStateText));
+        gFrameTimeDraw.pText = gCmdStateText;
+        cmdDrawTextWithFont(cmd, float2(8.f, txtSizePx.y + gpuSizePx.y + 90.f), &gFrameTimeDraw);
 
         cmdDrawUserInterface(cmd);
 
+        endPipelineStatsPass(cmd, pStatsPool, PIPELINE_STATS_PASS_UI);
+        traceGpuEnd(cmd);
         cmdEndGpuTimestampQuery(cmd, gGpuProfileToken);
         cmdBindRenderTargets(cmd, NULL);
 
@@ -1040,27 +1820,33 @@ public:
 
         if (pRenderer->pGpu->mPipelineStatsQueries)
         {
-            QueryDesc queryDesc = { 1 };
-            cmdEndQuery(cmd, pPipelineStatsQueryPool[gFrameIndex], &queryDesc);
-            cmdResolveQuery(cmd, pPipelineStatsQueryPool[gFrameIndex], 0, 2);
+            cmdResolveQuery(cmd, pStatsPool, firstStatsPass * PIPELINE_STATS_QUERY_STRIDE,
+                            (PIPELINE_STATS_PASS_COUNT - firstStatsPass) * PIPELINE_STATS_QUERY_STRIDE);
         }
 
+        traceCaptureEndFrame(cmd);
         endCmd(cmd);
+        recordFrameRecordTime(prerecorded, getUSec(true) - frameRecordStart);
+        cmdStateEndFrame(&gCmdStateFrame, &gCmdStateLastFrame);
 
         FlushResourceUpdateDesc flushUpdateDesc = {};
         flushUpdateDesc.mNodeIndex = 0;
         flushResourceUpdates(&flushUpdateDesc);
         Semaphore* waitSemaphores[2] = { flushUpdateDesc.pOutSubmittedSemaphore, pImageAcquiredSemaphore };
 
+        Cmd*            submitCmds[2] = { pSkyboxCmd, cmd };
         QueueSubmitDesc submitDesc = {};
-        submitDesc.mCmdCount = 1;
+        submitDesc.mCmdCount = prerecorded ? 2 : 1;
         submitDesc.mSignalSemaphoreCount = 1;
         submitDesc.mWaitSemaphoreCount = TF_ARRAY_COUNT(waitSemaphores);
-        submitDesc.ppCmds = &cmd;
+        submitDesc.ppCmds = prerecorded ? submitCmds : &cmd;
         submitDesc.ppSignalSemaphores = &elem.pSemaphore;
         submitDesc.ppWaitSemaphores = waitSemaphores;
         submitDesc.pSignalFence = elem.pFence;
+        traceCaptureSubmit();
         queueSubmit(pGraphicsQueue, &submitDesc);
+        if (prerecorded)
+            gSkyboxCmds[swapchainImageIndex][gFrameIndex].pLastFence = elem.pFence;
 
         QueuePresentDesc presentDesc = {};
         presentDesc.mIndex = (uint8_t)swapchainImageIndex;
@@ -1069,14 +1855,128 @@ public:
         presentDesc.ppWaitSemaphores = &elem.pSemaphore;
         presentDesc.mSubmitDone = true;
 
-        queuePresent(pGraphicsQueue, &presentDesc);
+        {
+            TRACE_SCOPE("Present");
+            queuePresent(pGraphicsQueue, &presentDesc);
+        }
         flipProfiler();
 
         gFrameIndex = (gFrameIndex + 1) % gDataBufferCount;
+        gPipelineStatsPoolIndex = (gPipelineStatsPoolIndex + 1) % gPipelineStatsPoolCount;
+        ++gFrameCount;
     }
 
     const char* GetName() { return "01_Transformations"; }
 
+    void drawSkybox(CmdStateCache* pState, RenderTarget* pRenderTarget, bool bindless)
+    {
+        const uint32_t skyboxVbStride = sizeof(float) * 4;
+        cmdStateSetViewport(pState, 0.0f, 0.0f, (float)pRenderTarget->mWidth, (float)pRenderTarget->mHeight, 1.0f, 1.0f);
+        if (bindless)
+        {
+            cmdStateBindPipeline(pState, pSkyBoxBindlessPipeline);
+            cmdStateBindDescriptorSet(pState, CMD_STATE_SET_PERSISTENT, 0, pDescriptorSetTexture);
+            cmdBindPushConstants(pState->pCmd, gFrameIdsIndex, &gFrameIndex);
+        }
+        else
+        {
+            cmdStateBindPipeline(pState, pSkyBoxDrawPipeline);
+            cmdStateBindDescriptorSet(pState, CMD_STATE_SET_PERSISTENT, 0, pDescriptorSetTexture);
+            cmdStateBindDescriptorSet(pState, CMD_STATE_SET_PER_FRAME, gFrameIndex, pDescriptorSetUniforms);
+        }
+        cmdStateBindVertexBuffer(pState, 1, &pSkyBoxVertexBuffer, &skyboxVbStride, NULL);
+        cmdStateDraw(pState, 36, 0);
+        cmdStateSetViewport(pState, 0.0f, 0.0f, (float)pRenderTarget->mWidth, (float)pRenderTarget->mHeight, 0.0f, 1.0f);
+    }
+
+    // Returns the skybox command buffer of this swapchain image and frame slot, recording it if it is missing or stale
+    Cmd* getSkyboxCmd(uint32_t imageIndex, RenderTarget* pRenderTarget)
+    {
+        PrerecordedCmd& recorded = gSkyboxCmds[imageIndex][gFrameIndex];
+        const bool      bindless = gBindlessDescriptors;
+
+        // A command buffer can neither be resubmitted nor re-recorded while the GPU still executes it
+        if (recorded.pLastFence)
+        {
+            FenceStatus fenceStatus;
+            getFenceStatus(pRenderer, recorded.pLastFence, &fenceStatus);
+            if (fenceStatus == FENCE_STATUS_INCOMPLETE)
+                waitForFences(pRenderer, 1, &recorded.pLastFence);
+        }
+
+        if (recorded.pCmd && recorded.mGeneration == gSkyboxCmdGeneration && recorded.mBindless == bindless)
+            return recorded.pCmd;
+
+        if (!recorded.pCmd)
+        {
+            CmdPoolDesc cmdPoolDesc = {};
+            cmdPoolDesc.pQueue = pGraphicsQueue;
+            initCmdPool(pRenderer, &cmdPoolDesc, &recorded.pCmdPool);
+            CmdDesc cmdDesc = {};
+            cmdDesc.pPool = recorded.pCmdPool;
+            initCmd(pRenderer, &cmdDesc, &recorded.pCmd);
+        }
+        else
+        {
+            resetCmdPool(pRenderer, recorded.pCmdPool);
+        }
+        recorded.mGeneration = gSkyboxCmdGeneration;
+        recorded.mBindless = bindless;
+
+        Cmd* cmd = recorded.pCmd;
+        beginCmd(cmd);
+        RenderTargetBarrier barrier = { pRenderTarget, RESOURCE_STATE_PRESENT, RESOURCE_STATE_RENDER_TARGET };
+        cmdResourceBarrier(cmd, 0, NULL, 0, NULL, 1, &barrier);
+        BindRenderTargetsDesc bindRenderTargets = {};
+        bindRenderTargets.mRenderTargetCount = 1;
+        bindRenderTargets.mRenderTargets[0] = { pRenderTarget, LOAD_ACTION_CLEAR };
+        bindRenderTargets.mDepthStencil = { pDepthBuffer, LOAD_ACTION_CLEAR };
+        // Recorded once, so its binds are not part of the per-frame counts
+        CmdStateCache state;
+        cmdStateBegin(&state, cmd, NULL);
+        cmdStateBindRenderTargets(&state, &bindRenderTargets);
+        cmdStateSetScissor(&state, 0, 0, pRenderTarget->mWidth, pRenderTarget->mHeight);
+        drawSkybox(&state, pRenderTarget, bindless);
+        cmdBindRenderTargets(cmd, NULL);
+        endCmd(cmd);
+        return cmd;
+    }
+
+    void removeSkyboxCmds()
+    {
+        for (uint32_t i = 0; i < gMaxPrerecordedImages; ++i)
+        {
+            for (uint32_t j = 0; j < gDataBufferCount; ++j)
+            {
+                PrerecordedCmd& recorded = gSkyboxCmds[i][j];
+                if (recorded.pCmd)
+                {
+                    exitCmd(pRenderer, recorded.pCmd);
+                    exitCmdPool(pRenderer, recorded.pCmdPool);
+                }
+                recorded = {};
+            }
+        }
+    }
+
+    void beginPipelineStatsPass(Cmd* cmd, QueryPool* pPool, uint32_t pass)
+    {
+        if (pRenderer->pGpu->mPipelineStatsQueries)
+        {
+            QueryDesc queryDesc = { pass * PIPELINE_STATS_QUERY_STRIDE };
+            cmdBeginQuery(cmd, pPool, &queryDesc);
+        }
+    }
+
+    void endPipelineStatsPass(Cmd* cmd, QueryPool* pPool, uint32_t pass)
+    {
+        if (pRenderer->pGpu->mPipelineStatsQueries)
+        {
+            QueryDesc queryDesc = { pass * PIPELINE_STATS_QUERY_STRIDE };
+            cmdEndQuery(cmd, pPool, &queryDesc);
+        }
+    }
+
     bool addSwapChain()
     {
         SwapChainDesc swapChainDesc = {};
@@ -1112,7 +2012,7 @@ public:
         depthRT.mSampleQuality = 0;
         depthRT.mWidth = mSettings.mWidth;
         depthRT.mFlags = TEXTURE_CREATION_FLAG_ESRAM | TEXTURE_CREATION_FLAG_ON_TILE | TEXTURE_CREATION_FLAG_VR_MULTIVIEW;
-        addRenderTarget(pRenderer, &depthRT, &pDepthBuffer);
+        gpuMemoryAddRenderTarget(pRenderer, &depthRT, &pDepthBuffer, "Depth Buffer");
 
         ESRAM_END_ALLOC(pRenderer);
 
@@ -1133,78 +2033,249 @@ public:
         removeDescriptorSet(pRenderer, pDescriptorSetTexture);
     }
 
+    // Creates one program from the archive when its copy matches binaryHash, otherwise from the loose binaries.
+    // Returns the hash of the binaries the shader was built from.
+    uint64_t loadProgramShader(const ShaderArchive* pArchive, uint32_t programIndex, uint64_t binaryHash, Shader** ppShader)
+    {
+        const ShaderProgram& program = gShaderPrograms[programIndex];
+        return addShaderPair(pRenderer, pArchive, program.pVert, program.pFrag, binaryHash, ppShader);
+    }
+
+    void addProgramShader(const ShaderArchive* pArchive, uint32_t programIndex, uint64_t binaryHash)
+    {
+        ShaderProgram& program = gShaderPrograms[programIndex];
+        if (*program.ppShader)
+        {
+            removeShader(pRenderer, *program.ppShader);
+            *program.ppShader = NULL;
+        }
+        program.mBinaryHash = loadProgramShader(pArchive, programIndex, binaryHash, program.ppShader);
+    }
+
+    // pBinaryHash receives the hash of the binaries the program would be built from now, 0 on the first load
+    bool isProgramStale(const ShaderArchive* pArchive, uint32_t programIndex, uint64_t* pBinaryHash)
+    {
+        const ShaderProgram& program = gShaderPrograms[programIndex];
+        *pBinaryHash = *program.ppShader ? getShaderPairHash(pArchive, program.pVert, program.pFrag) : 0;
+        // Without any binary hash there is nothing to compare against, so the program is always rebuilt
+        return !*program.ppShader || !*pBinaryHash || *pBinaryHash != program.mBinaryHash;
+    }
+
     void addShaders()
     {
-        ShaderLoadDesc skyShader = {};
-        skyShader.mVert.pFileName = "skybox.vert";
-        skyShader.mFrag.pFileName = "skybox.frag";
+        ShaderArchive archive = {};
+        openShaderArchive(GetName(), &archive);
 
-        ShaderLoadDesc basicShader = {};
-        basicShader.mVert.pFileName = "basic.vert";
-        basicShader.mFrag.pFileName = "basic.frag";
+        for (uint32_t i = 0; i < SHADER_PROGRAM_COUNT; ++i)
+        {
+            uint64_t binaryHash = 0;
+            if (isProgramStale(&archive, i, &binaryHash))
+                addProgramShader(&archive, i, binaryHash);
+        }
 
-        addShader(pRenderer, &skyShader, &pSkyBoxDrawShader);
-        addShader(pRenderer, &basicShader, &pSphereShader);
+        // Shaders own a copy of their byte code, the mapping is not needed past this point
+        closeShaderArchive(&archive);
     }
 
     void removeShaders()
     {
-        removeShader(pRenderer, pSphereShader);
-        removeShader(pRenderer, pSkyBoxDrawShader);
+        for (uint32_t i = 0; i < SHADER_PROGRAM_COUNT; ++i)
+        {
+            ShaderProgram& program = gShaderPrograms[i];
+            if (*program.ppShader)
+                removeShader(pRenderer, *program.ppShader);
+            *program.ppShader = NULL;
+            program.mBinaryHash = 0;
+        }
     }
 
-    void addPipelines()
+    // Fine grained RELOAD_TYPE_SHADER: only programs whose binaries changed get a new shader and pipeline.
+    // Descriptor sets, UI and font resources are left alone, the planet mesh is only regenerated when the
+    // vertex layout slider (which also requests a shader reload) actually changed the layout.
+    // Nothing here waits on the GPU: new pipelines compile on the background thread and are swapped in by
+    // installCompiledPipelines(), replaced objects go through the retire list.
+    void reloadChangedShaders()
     {
-        RasterizerStateDesc rasterizerStateDesc = {};
-        rasterizerStateDesc.mCullMode = CULL_MODE_NONE;
+        ShaderArchive archive = {};
+        openShaderArchive(GetName(), &archive);
 
-        RasterizerStateDesc sphereRasterizerStateDesc = {};
-        sphereRasterizerStateDesc.mCullMode = CULL_MODE_FRONT;
+        bool     shaderStale[SHADER_PROGRAM_COUNT] = {};
+        bool     pipelineStale[SHADER_PROGRAM_COUNT] = {};
+        uint64_t binaryHashes[SHADER_PROGRAM_COUNT] = {};
+        for (uint32_t i = 0; i < SHADER_PROGRAM_COUNT; ++i)
+        {
+            shaderStale[i] = isProgramStale(&archive, i, &binaryHashes[i]);
+            pipelineStale[i] = shaderStale[i];
+        }
+        const bool layoutChanged = gSphereMeshLayoutType != gSphereLayoutType;
+        pipelineStale[SHADER_PROGRAM_SPHERE] |= layoutChanged;
+        pipelineStale[SHADER_PROGRAM_SPHERE_BINDLESS] |= layoutChanged;
 
-        DepthStateDesc depthStateDesc = {};
-        depthStateDesc.mDepthTest = true;
-        depthStateDesc.mDepthWrite = true;
-        depthStateDesc.mDepthFunc = CMP_GEQUAL;
+        if (layoutChanged)
+        {
+            // The old pipelines cannot read the new vertex layout, planets are skipped until the new ones are ready
+            retireResource(RETIRED_PIPELINE, pSpherePipeline);
+            retireResource(RETIRED_PIPELINE, pSphereBindlessPipeline);
+            retireResource(RETIRED_BUFFER, pSphereVertexBuffer);
+            retireResource(RETIRED_BUFFER, pSphereIndexBuffer);
+            pSpherePipeline = NULL;
+            pSphereBindlessPipeline = NULL;
+            generate_complex_mesh();
+        }
+
+        for (uint32_t i = 0; i < SHADER_PROGRAM_COUNT; ++i)
+        {
+            if (!pipelineStale[i])
+                continue;
+
+            // A pending shader is newer than the one in use and is what mBinaryHash already refers to
+            Shader* pShader = gPendingPipelines[i].mActive ? gPendingPipelines[i].pShader : *gShaderPrograms[i].ppShader;
+            if (shaderStale[i])
+            {
+                pShader = NULL;
+                gShaderPrograms[i].mBinaryHash = loadProgramShader(&archive, i, binaryHashes[i], &pShader);
+            }
+            requestPipelineCompile(i, pShader);
+        }
+
+        closeShaderArchive(&archive);
+    }
 
-        PipelineDesc desc = {};
+    void initPipelineCompileJob(uint32_t programIndex, Shader* pShader, PipelineCompileJob* pJob)
+    {
+        *pJob = {};
+        pJob->mColorFormat = pSwapChain->ppRenderTargets[0]->mFormat;
+
+        PipelineDesc& desc = pJob->mDesc;
         desc.mType = PIPELINE_TYPE_GRAPHICS;
+        desc.pCache = pPipelineCache;
         PIPELINE_LAYOUT_DESC(desc, SRT_LAYOUT_DESC(SrtData, Persistent), SRT_LAYOUT_DESC(SrtData, PerFrame), NULL, NULL);
         GraphicsPipelineDesc& pipelineSettings = desc.mGraphicsDesc;
         pipelineSettings.mPrimitiveTopo = PRIMITIVE_TOPO_TRI_LIST;
         pipelineSettings.mRenderTargetCount = 1;
-        pipelineSettings.pDepthState = &depthStateDesc;
-        pipelineSettings.pColorFormats = &pSwapChain->ppRenderTargets[0]->mFormat;
+        pipelineSettings.pColorFormats = &pJob->mColorFormat;
         pipelineSettings.mSampleCount = pSwapChain->ppRenderTargets[0]->mSampleCount;
         pipelineSettings.mSampleQuality = pSwapChain->ppRenderTargets[0]->mSampleQuality;
         pipelineSettings.mDepthStencilFormat = pDepthBuffer->mFormat;
-        pipelineSettings.pShaderProgram = pSphereShader;
-        pipelineSettings.pVertexLayout = &gSphereVertexLayout;
-        pipelineSettings.pRasterizerState = &sphereRasterizerStateDesc;
+        pipelineSettings.pShaderProgram = pShader;
         pipelineSettings.mVRFoveatedRendering = true;
-        addPipeline(pRenderer, &desc, &pSpherePipeline);
-
-        // layout and pipeline for skybox draw
-        VertexLayout vertexLayout = {};
-        vertexLayout.mBindingCount = 1;
-        vertexLayout.mBindings[0].mStride = sizeof(float4);
-        vertexLayout.mAttribCount = 1;
-        vertexLayout.mAttribs[0].mSemantic = SEMANTIC_POSITION;
-        vertexLayout.mAttribs[0].mFormat = TinyImageFormat_R32G32B32A32_SFLOAT;
-        vertexLayout.mAttribs[0].mBinding = 0;
-        vertexLayout.mAttribs[0].mLocation = 0;
-        vertexLayout.mAttribs[0].mOffset = 0;
-        pipelineSettings.pVertexLayout = &vertexLayout;
-
-        pipelineSettings.pDepthState = NULL;
-        pipelineSettings.pRasterizerState = &rasterizerStateDesc;
-        pipelineSettings.pShaderProgram = pSkyBoxDrawShader; //-V519
-        addPipeline(pRenderer, &desc, &pSkyBoxDrawPipeline);
+        pipelineSettings.pVertexLayout = &pJob->mVertexLayout;
+        pipelineSettings.pRasterizerState = &pJob->mRasterizerState;
+
+        switch (programIndex)
+        {
+        case SHADER_PROGRAM_SPHERE:
+        case SHADER_PROGRAM_SPHERE_BINDLESS:
+            pJob->mVertexLayout = gSphereVertexLayout;
+            pJob->mRasterizerState.mCullMode = CULL_MODE_FRONT;
+            pJob->mDepthState.mDepthTest = true;
+            pJob->mDepthState.mDepthWrite = true;
+            pJob->mDepthState.mDepthFunc = CMP_GEQUAL;
+            pipelineSettings.pDepthState = &pJob->mDepthState;
+            break;
+        case SHADER_PROGRAM_SKYBOX:
+        case SHADER_PROGRAM_SKYBOX_BINDLESS:
+        {
+            // layout for skybox draw
+            VertexLayout& skyVertexLayout = pJob->mVertexLayout;
+            skyVertexLayout.mBindingCount = 1;
+            skyVertexLayout.mBindings[0].mStride = sizeof(float4);
+            skyVertexLayout.mAttribCount = 1;
+            skyVertexLayout.mAttribs[0].mSemantic = SEMANTIC_POSITION;
+            skyVertexLayout.mAttribs[0].mFormat = TinyImageFormat_R32G32B32A32_SFLOAT;
+            skyVertexLayout.mAttribs[0].mBinding = 0;
+            skyVertexLayout.mAttribs[0].mLocation = 0;
+            skyVertexLayout.mAttribs[0].mOffset = 0;
+            pJob->mRasterizerState.mCullMode = CULL_MODE_NONE;
+            pipelineSettings.pDepthState = NULL;
+            break;
+        }
+        }
+    }
+
+    void addProgramPipeline(uint32_t programIndex)
+    {
+        const ShaderProgram& program = gShaderPrograms[programIndex];
+
+        PipelineCompileJob job;
+        initPipelineCompileJob(programIndex, *program.ppShader, &job);
+
+        int64_t start = getUSec(true);
+        addPipeline(pRenderer, &job.mDesc, program.ppPipeline);
+        LOGF(LogLevel::eINFO, "Pipeline creation (%s cache): %s %.3f ms", gPipelineCacheWarm ? "warm" : "cold", program.pPipelineName,
+             (getUSec(true) - start) / 1000.0f);
+    }
+
+    void requestPipelineCompile(uint32_t programIndex, Shader* pShader)
+    {
+        const ShaderProgram& program = gShaderPrograms[programIndex];
+        PendingPipeline&     pending = gPendingPipelines[programIndex];
+        if (pending.mActive)
+        {
+            // Superseded before it was swapped in, the GPU has never seen any of it
+            waitPipelineCompile(&pending.mJob);
+            removePipeline(pRenderer, pending.mJob.pPipeline);
+            if (pending.pShader != *program.ppShader && pending.pShader != pShader)
+                removeShader(pRenderer, pending.pShader);
+        }
+
+        pending.pShader = pShader;
+        pending.mRequestTime = getUSec(true);
+        pending.mActive = true;
+        initPipelineCompileJob(programIndex, pShader, &pending.mJob);
+        queuePipelineCompile(&pending.mJob);
+    }
+
+    void installCompiledPipelines()
+    {
+        for (uint32_t i = 0; i < SHADER_PROGRAM_COUNT; ++i)
+        {
+            PendingPipeline& pending = gPendingPipelines[i];
+            if (!pending.mActive || !tfrg_atomic32_load_acquire(&pending.mJob.mDone))
+                continue;
+
+            ShaderProgram& program = gShaderPrograms[i];
+            Shader*        pOldShader = pending.pShader != *program.ppShader ? *program.ppShader : NULL;
+            retireResource(RETIRED_PIPELINE, *program.ppPipeline);
+            retireResource(RETIRED_SHADER, pOldShader);
+            *program.ppPipeline = pending.mJob.pPipeline;
+            *program.ppShader = pending.pShader;
+            pending.mActive = false;
+            ++gSkyboxCmdGeneration;
+
+            gLastReloadSwapMs = (getUSec(true) - pending.mRequestTime) / 1000.0f;
+            LOGF(LogLevel::eINFO, "Pipeline swap: %s compiled in %.3f ms, live %.3f ms after the reload request", program.pPipelineName,
+                 pending.mJob.mCompileMs, gLastReloadSwapMs);
+            updateReloadStatsText();
+        }
+    }
+
+    void finishPipelineCompiles()
+    {
+        for (uint32_t i = 0; i < SHADER_PROGRAM_COUNT; ++i)
+        {
+            if (gPendingPipelines[i].mActive)
+                waitPipelineCompile(&gPendingPipelines[i].mJob);
+        }
+        installCompiledPipelines();
+    }
+
+    void addPipelines()
+    {
+        for (uint32_t i = 0; i < SHADER_PROGRAM_COUNT; ++i)
+            addProgramPipeline(i);
+
+        // Every pipeline created from here on hits the in-memory cache populated above
+        gPipelineCacheWarm = true;
     }
 
     void removePipelines()
     {
-        removePipeline(pRenderer, pSkyBoxDrawPipeline);
-        removePipeline(pRenderer, pSpherePipeline);
+        for (uint32_t i = 0; i < SHADER_PROGRAM_COUNT; ++i)
+        {
+            removePipeline(pRenderer, *gShaderPrograms[i].ppPipeline);
+            *gShaderPrograms[i].ppPipeline = NULL;
+        }
     }
 
     void prepareDescriptorSets()
@@ -1227,6 +2298,16 @@ public:
         params[6].ppSamplers = &pSkyBoxSampler;
         updateDescriptorSet(pRenderer, 0, pDescriptorSetTexture, TF_ARRAY_COUNT(params), params);
 
+        // The descriptor array table views the same textures and uniform buffers, written once with the rest of the set
+        DescriptorData bindlessParams[2] = {};
+        bindlessParams[0].mIndex = SRT_RES_IDX(SrtData, Persistent, gBindlessTextures);
+        bindlessParams[0].ppTextures = pSkyBoxTextures;
+        bindlessParams[0].mCount = TF_ARRAY_COUNT(pSkyBoxTextures);
+        bindlessParams[1].mIndex = SRT_RES_IDX(SrtData, Persistent, gBindlessUniforms);
+        bindlessParams[1].ppBuffers = pUniformBuffer;
+        bindlessParams[1].mCount = gDataBufferCount;
+        updateDescriptorSet(pRenderer, 0, pDescriptorSetTexture, TF_ARRAY_COUNT(bindlessParams), bindlessParams);
+
         for (uint32_t i = 0; i < gDataBufferCount; ++i)
         {
             DescriptorData uParams[1] = {};
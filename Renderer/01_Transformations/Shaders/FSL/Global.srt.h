@@ -35,9 +35,17 @@ BEGIN_SRT_NO_AB(SrtData)
         DECL_TEXTURE(Persistent, Tex2D(float4), gFrontTexture)
         DECL_TEXTURE(Persistent, Tex2D(float4), gBackTexture)
         DECL_SAMPLER(Persistent, SamplerState, gSampler)
+        // Descriptor array mode: all six skybox faces and every frame's uniforms in one table, indexed by the shaders
+        DECL_ARRAY(Persistent, Tex2D(float4), gBindlessTextures, 6)
+        DECL_ARRAY(Persistent, Buffer(UniformData), gBindlessUniforms, 2)
     END_SRT_SET(Persistent)
     BEGIN_SRT_SET(PerFrame)
         DECL_CBUFFER(PerFrame, CBUFFER(UniformData), gUniformBlock)
     END_SRT_SET(PerFrame)
 END_SRT(SrtData)
 
+// Frame slot of the descriptor array mode, selects the frame's uniform buffer in gBindlessUniforms
+PUSH_CONSTANT(gFrameIds, b0)
+{
+    DATA(uint, frameIndex, None);
+};
@@ -35,6 +35,7 @@
 #include "../../../../Common_3/Game/Interfaces/IScripting.h"
 #include "../../../../Common_3/Utilities/Interfaces/IFileSystem.h"
 #include "../../../../Common_3/Utilities/Interfaces/ILog.h"
+#include "../../../../Common_3/Utilities/Interfaces/IThread.h"
 #include "../../../../Common_3/Utilities/Interfaces/ITime.h"
 
 // Renderer
@@ -54,6 +55,23 @@
 
 // Button bit definitions
 #include "ButtonDefs.h"
+#include "ButtonLayout.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BUTTON_SNAPSHOT_SSE
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define BUTTON_SNAPSHOT_NEON
+#endif
+
+#include "../Shared/InitTimeline.h"
+#include "../Shared/InputRecorder.h"
+#include "../Shared/Percentiles.h"
+#include "../Shared/PipelineCacheName.h"
+#include "../Shared/ShaderArchive.h"
+#include "../Shared/SpscRing.h"
+#include "../Shared/TraceCapture.h"
 
 /************************************************************************/
 // Keep in sync with Common_3/OS/Input/InputCommon.h
@@ -208,6 +226,123 @@ action(GPAD_R2)
 
 DECL_INPUTS(VAR_ACTION)
 
+// Every input is bound to a custom action of the same name. The whole binding text is one string literal built at
+// compile time and registered with a single inputAddCustomBindings() call, --input-bindings-per-line restores the
+// per-input registration and --input-bindings-check compares the resulting enums with a run of the other path.
+struct InputBinding
+{
+    const char* pName;
+    InputEnum*  pEnum;
+};
+
+#define BINDING_LINE(x)  #x "; analog; " #x "; 1.0f\n"
+#define BINDING_ENTRY(x) { #x, &x },
+
+static constexpr char         gInputBindingText[] = DECL_INPUTS(BINDING_LINE);
+static constexpr InputBinding gInputBindings[] = { DECL_INPUTS(BINDING_ENTRY) };
+
+constexpr bool bindingNamesEqual(const char* a, const char* b) { return *a == *b && (!*a || bindingNamesEqual(a + 1, b + 1)); }
+
+template<uint32_t N> constexpr bool bindingTableIsValid(const InputBinding (&table)[N], const char* text)
+{
+    uint32_t lines = 0;
+    for (const char* c = text; *c; ++c)
+        lines += *c == '\n';
+    if (lines != N)
+        return false;
+    for (uint32_t i = 0; i < N; ++i)
+    {
+        for (uint32_t j = i + 1; j < N; ++j)
+        {
+            if (bindingNamesEqual(table[i].pName, table[j].pName))
+                return false;
+        }
+    }
+    return true;
+}
+
+COMPILE_ASSERT(bindingTableIsValid(gInputBindings, gInputBindingText));
+
+bool gInputBindingsPerLine = false;
+bool gInputBindingsCheck = false;
+
+static void addInputBindingsPerLine()
+{
+#define BINDING_ACTION(x)                                \
+    inputAddCustomBindings(#x "; analog; " #x "; 1.0f"); \
+    x = inputGetCustomBindingEnum(#x);
+    DECL_INPUTS(BINDING_ACTION)
+#undef BINDING_ACTION
+}
+
+static void addInputBindings()
+{
+    inputAddCustomBindings(gInputBindingText);
+    for (uint32_t i = 0; i < TF_ARRAY_COUNT(gInputBindings); ++i)
+        *gInputBindings[i].pEnum = inputGetCustomBindingEnum(gInputBindings[i].pName);
+}
+
+// Registering the other path in the same run would rebind names that already exist, so the check saves the enums of
+// this clean registration to the log directory and compares them with the file a run of the other path wrote
+static void checkInputBindings()
+{
+    const uint32_t count = (uint32_t)TF_ARRAY_COUNT(gInputBindings);
+    const char*    fileNames[] = { "34_Input_Bindings_Bulk.bin", "34_Input_Bindings_PerLine.bin" };
+    InputEnum      enums[TF_ARRAY_COUNT(gInputBindings)];
+    for (uint32_t i = 0; i < count; ++i)
+        enums[i] = *gInputBindings[i].pEnum;
+
+    FileStream stream = {};
+    if (fsOpenStreamFromPath(RD_LOG, fileNames[gInputBindingsPerLine], FM_WRITE, &stream))
+    {
+        fsWriteToStream(&stream, &count, sizeof(count));
+        fsWriteToStream(&stream, enums, sizeof(enums));
+        fsCloseStream(&stream);
+    }
+
+    InputEnum other[TF_ARRAY_COUNT(gInputBindings)];
+    uint32_t  otherCount = 0;
+    bool      valid = fsOpenStreamFromPath(RD_LOG, fileNames[!gInputBindingsPerLine], FM_READ, &stream);
+    if (valid)
+    {
+        valid = fsReadFromStream(&stream, &otherCount, sizeof(otherCount)) == sizeof(otherCount) && otherCount == count &&
+                fsReadFromStream(&stream, other, sizeof(other)) == sizeof(other);
+        fsCloseStream(&stream);
+    }
+    if (!valid)
+    {
+        LOGF(LogLevel::eINFO, "Input binding check: saved %s, run again %s --input-bindings-per-line to compare",
+             fileNames[gInputBindingsPerLine], gInputBindingsPerLine ? "without" : "with");
+        return;
+    }
+
+    uint32_t mismatches = 0;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (memcmp(&enums[i], &other[i], sizeof(InputEnum)) != 0)
+        {
+            LOGF(LogLevel::eERROR, "Input binding %s resolves differently in bulk and per line", gInputBindings[i].pName);
+            ++mismatches;
+        }
+    }
+    LOGF(LogLevel::eINFO, "Input binding check: %u of %u enums match %s", count - mismatches, count, fileNames[!gInputBindingsPerLine]);
+}
+
+// Registers the bindings the selected way and logs how long it took
+static void registerInputBindings()
+{
+    const int64_t start = getUSec(true);
+    if (gInputBindingsPerLine)
+        addInputBindingsPerLine();
+    else
+        addInputBindings();
+    LOGF(LogLevel::eINFO, "Input bindings (%s): %u bindings in %.3f ms", gInputBindingsPerLine ? "per line" : "bulk",
+         (uint32_t)TF_ARRAY_COUNT(gInputBindings), (getUSec(true) - start) / 1000.0f);
+
+    if (gInputBindingsCheck)
+        checkInputBindings();
+}
+
 #if defined(ENABLE_FORGE_TOUCH_INPUT)
 enum TouchPhase
 {
@@ -250,17 +385,14 @@ struct ConstantData
     uint32_t buttonSet1 = 0;
     uint32_t buttonSet2 = 0;
     uint32_t buttonSet3 = 0;
+    uint32_t buttonIdMask = 0;
 };
 
 ConstantData   gConstantData;
 // For UI purposes, a custom variable to remove 'invalid' device type - 0.Gamepad 1.KBM 2.Touch
 uint32_t       gChosenDeviceType = 0;
 InputPortIndex gGamepadIndex = 0;
-char           gGamepadNames[MAX_GAMEPADS][FS_MAX_PATH] = {};
 bool           gEnableRumbleAndLights = false;
-#if defined(ENABLE_FORGE_TOUCH_INPUT)
-TouchEvent gTouches[16] = {};
-#endif
 
 #define ARRAY_LENGTH(a) (sizeof(a) / sizeof(a[0]))
 
@@ -276,23 +408,68 @@ SwapChain* pSwapChain = NULL;
 Semaphore* pImageAcquiredSemaphore = NULL;
 
 Shader*   pBasicShader = NULL;
+uint64_t  gBasicShaderBinaryHash = 0; // Hash of the binaries pBasicShader was built from
 Pipeline* pBasicPipeline = NULL;
 
+Shader*   pHighlightShader = NULL;
+uint64_t  gHighlightShaderBinaryHash = 0;
+Pipeline* pHighlightPipeline = NULL;
+
 Buffer* pQuadVertexBuffer = NULL;
 Buffer* pQuadIndexBuffer = NULL;
 
 Texture*       pGamepad = NULL;
 Texture*       pKeyboardMouse = NULL;
-Texture*       pInputDeviceTexture = NULL;
-Texture*       pPrevInputDeviceTexture = NULL;
+// Button-ID masks baked by Shared/Tools/bake_button_ids.py. Without them both point at a 1x1 placeholder so
+// gButtonIds stays bound, and highlights keep using the instanced circles.
+Texture*       pGamepadIds = NULL;
+Texture*       pKeyboardMouseIds = NULL;
+bool           gButtonIdMaskAvailable = false;
+bool           gButtonIdMask = false;
+// One persistent set per textured device, indexed by deviceType, so a device switch only changes which one Draw binds
+const uint32_t gDeviceDescriptorCount = 2;
+COMPILE_ASSERT(INPUT_DEVICE_GAMEPAD == 0 && INPUT_DEVICE_KBM == 1);
 DescriptorSet* pDescriptorDevice = NULL;
 DescriptorSet* pDescriptorInputData = NULL;
 
 Buffer* pInputDataUniformBuffer[gDataBufferCount] = { NULL };
 
+// Pressed buttons and axis markers, one instanced circle each (highlight.vert.fsl): xy center in device texture space
+// (ButtonLayout.h), z radius
+const uint32_t gMaxHighlights = 128;
+const float    gAxisProjectionScale = 0.05f;
+Buffer*        pHighlightBuffer[gDataBufferCount] = { NULL };
+float4         gHighlights[gMaxHighlights] = {};
+uint32_t       gHighlightCount[gDataBufferCount] = {};
+
+// Shared by every pipeline this sample creates, loaded in Init and written back to disk in Exit
+PipelineCache* pPipelineCache = NULL;
+char           gPipelineCacheName[FS_MAX_PATH] = {};
+bool           gPipelineCacheWarm = false;
+
+// Cold start budget for Init(), see logInitTimeline()
+const float gInitBudgetMs = 300.0f;
+
+// Number of frames recorded by the "Capture Chrome Trace" button
+uint32_t gTraceFrameCount = 60;
+
 uint32_t     gFrameIndex = 0;
 ProfileToken gGpuProfileToken = PROFILE_INVALID_TOKEN;
 
+// gConstantData is only uploaded to the uniform buffers whose bit is set, markInputDirty() sets all of them
+uint32_t     gUniformDirtyMask = (1u << gDataBufferCount) - 1;
+ConstantData gLastConstantData = {};
+
+// On-demand rendering skips acquire, record and present while neither the input state nor the UI changed.
+// Every change renders a few frames so UI hover and press states settle before the sample goes idle again.
+bool           gOnDemandRendering = false;
+const uint32_t gRedrawFrameCount = 3;
+const uint32_t gIdleSleepMs = 8;
+uint32_t       gRedrawFrames = gRedrawFrameCount;
+float          gLastMouse[2] = {};
+uint32_t       gRenderedFrames = 0;
+uint32_t       gSkippedFrames = 0;
+
 /// UI
 UIComponent* pGuiWindow = NULL;
 
@@ -303,10 +480,269 @@ FontDrawDesc gFrameTimeDraw = FontDrawDesc{ NULL, 0, 0xff00ffff, 18 };
 Vertex gQuadVerts[4];
 ///////////////////////////////////////////////////////////////////////////
 
-#define SET_BUTTON_BIT(set, state, button_bit) ((set) = (state) ? ((set) | (button_bit)) : ((set) & ~(button_bit)));
+// One entry per button: the input it is read from, its bit in gConstantData.buttonSet0..3 and the circle that
+// highlights it while pressed (ButtonLayout.h). The bit masks come from ButtonDefs.h.
+struct ButtonBinding
+{
+    const InputEnum* pInput;
+    uint32_t         mSet;
+    uint32_t         mMask;
+    ButtonPos        mPos;
+    float            mRadius;
+};
+
+// clang-format off
+static constexpr ButtonBinding gGamepadButtons[] = {
+    { &GPAD_LEFT,  0, CONTROLLER_DPAD_LEFT_BIT,  BUTTON_DPAD_LEFT_POS,  0.02f },
+    { &GPAD_RIGHT, 0, CONTROLLER_DPAD_RIGHT_BIT, BUTTON_DPAD_RIGHT_POS, 0.02f },
+    { &GPAD_UP,    0, CONTROLLER_DPAD_UP_BIT,    BUTTON_DPAD_UP_POS,    0.02f },
+    { &GPAD_DOWN,  0, CONTROLLER_DPAD_DOWN_BIT,  BUTTON_DPAD_DOWN_POS,  0.02f },
+    { &GPAD_A,     0, CONTROLLER_A_BIT,          BUTTON_SOUTH_POS,      0.03f },
+    { &GPAD_B,     0, CONTROLLER_B_BIT,          BUTTON_EAST_POS,       0.03f },
+    { &GPAD_X,     0, CONTROLLER_X_BIT,          BUTTON_WEST_POS,       0.03f },
+    { &GPAD_Y,     0, CONTROLLER_Y_BIT,          BUTTON_NORTH_POS,      0.03f },
+    { &GPAD_L1,    0, CONTROLLER_L1_BIT,         BUTTON_L1_POS,         0.02f },
+    { &GPAD_R1,    0, CONTROLLER_R1_BIT,         BUTTON_R1_POS,         0.02f },
+    { &GPAD_L3,    0, CONTROLLER_L3_BIT,         BUTTON_L3_POS,         0.03f },
+    { &GPAD_R3,    0, CONTROLLER_R3_BIT,         BUTTON_R3_POS,         0.03f },
+    { &GPAD_START, 0, CONTROLLER_START_BIT,      BUTTON_START_POS,      0.01f },
+    { &GPAD_BACK,  0, CONTROLLER_SELECT_BIT,     BUTTON_SELECT_POS,     0.01f },
+};
+
+static constexpr ButtonBinding gKeyboardMouseButtons[] = {
+    { &K_ESCAPE,         0, ESCAPE_BIT,         ESCAPE_POS,         0.02f },
+    { &K_F1,             0, F1_BIT,             F1_POS,             0.02f },
+    { &K_F2,             0, F2_BIT,             F2_POS,             0.02f },
+    { &K_F3,             0, F3_BIT,             F3_POS,             0.02f },
+    { &K_F4,             0, F4_BIT,             F4_POS,             0.02f },
+    { &K_F5,             0, F5_BIT,             F5_POS,             0.02f },
+    { &K_F6,             0, F6_BIT,             F6_POS,             0.02f },
+    { &K_F7,             0, F7_BIT,             F7_POS,             0.02f },
+    { &K_F8,             0, F8_BIT,             F8_POS,             0.02f },
+    { &K_F9,             0, F9_BIT,             F9_POS,             0.02f },
+    { &K_F10,            0, F10_BIT,            F10_POS,            0.02f },
+    { &K_F11,            0, F11_BIT,            F11_POS,            0.02f },
+    { &K_F12,            0, F12_BIT,            F12_POS,            0.02f },
+    { &K_INS,            0, INSERT_BIT,         INSERT_POS,         0.02f },
+    { &K_DEL,            0, DEL_BIT,            DEL_POS,            0.02f },
+    { &K_KP_NUMLOCK,     0, NUM_LOCK_BIT,       NUM_LOCK_POS,       0.02f },
+    { &K_KP_STAR,        0, KP_MULTIPLY_BIT,    KP_MULTIPLY_POS,    0.02f },
+    { &K_1,              0, NUM_1_BIT,          NUM_1_POS,          0.02f },
+    { &K_2,              0, NUM_2_BIT,          NUM_2_POS,          0.02f },
+    { &K_3,              0, NUM_3_BIT,          NUM_3_POS,          0.02f },
+    { &K_4,              0, NUM_4_BIT,          NUM_4_POS,          0.02f },
+    { &K_5,              0, NUM_5_BIT,          NUM_5_POS,          0.02f },
+    { &K_6,              0, NUM_6_BIT,          NUM_6_POS,          0.02f },
+    { &K_7,              0, NUM_7_BIT,          NUM_7_POS,          0.02f },
+    { &K_8,              0, NUM_8_BIT,          NUM_8_POS,          0.02f },
+    { &K_9,              0, NUM_9_BIT,          NUM_9_POS,          0.02f },
+    { &K_0,              0, NUM_0_BIT,          NUM_0_POS,          0.02f },
+    { &K_MINUS,          0, MINUS_BIT,          MINUS_POS,          0.02f },
+    { &K_EQUAL,          0, EQUAL_BIT,          EQUAL_POS,          0.02f },
+    { &K_BACKSPACE,      0, BACK_SPACE_BIT,     BACK_SPACE_POS,     0.02f },
+    { &K_KP_PLUS,        1, KP_ADD_BIT,         KP_ADD_POS,         0.02f },
+    { &K_KP_MINUS,       1, KP_SUBTRACT_BIT,    KP_SUBTRACT_POS,    0.02f },
+    { &K_TAB,            1, TAB_BIT,            TAB_POS,            0.02f },
+    { &K_Q,              1, Q_BIT,              Q_POS,              0.02f },
+    { &K_W,              1, W_BIT,              W_POS,              0.02f },
+    { &K_E,              1, E_BIT,              E_POS,              0.02f },
+    { &K_R,              1, R_BIT,              R_POS,              0.02f },
+    { &K_T,              1, T_BIT,              T_POS,              0.02f },
+    { &K_Y,              1, Y_BIT,              Y_POS,              0.02f },
+    { &K_U,              1, U_BIT,              U_POS,              0.02f },
+    { &K_I,              1, I_BIT,              I_POS,              0.02f },
+    { &K_O,              1, O_BIT,              O_POS,              0.02f },
+    { &K_P,              1, P_BIT,              P_POS,              0.02f },
+    { &K_LEFTBRACKET,    1, BRACKET_LEFT_BIT,   BRACKET_LEFT_POS,   0.02f },
+    { &K_RIGHTBRACKET,   1, BRACKET_RIGHT_BIT,  BRACKET_RIGHT_POS,  0.02f },
+    { &K_BACKSLASH,      1, BACK_SLASH_BIT,     BACK_SLASH_POS,     0.02f },
+    { &K_KP_HOME,        1, KP_7_HOME_BIT,      KP_7_HOME_POS,      0.02f },
+    { &K_KP_UPARROW,     1, KP_8_UP_BIT,        KP_8_UP_POS,        0.02f },
+    { &K_KP_PGUP,        1, KP_9_PAGE_UP_BIT,   KP_9_PAGE_UP_POS,   0.02f },
+    { &K_CAPSLOCK,       1, CAPS_LOCK_BIT,      CAPS_LOCK_POS,      0.02f },
+    { &K_A,              1, A_BIT,              A_POS,              0.02f },
+    { &K_S,              1, S_BIT,              S_POS,              0.02f },
+    { &K_D,              1, D_BIT,              D_POS,              0.02f },
+    { &K_F,              1, F_BIT,              F_POS,              0.02f },
+    { &K_G,              1, G_BIT,              G_POS,              0.02f },
+    { &K_H,              1, H_BIT,              H_POS,              0.02f },
+    { &K_J,              1, J_BIT,              J_POS,              0.02f },
+    { &K_K,              1, K_BIT,              K_POS,              0.02f },
+    { &K_L,              1, L_BIT,              L_POS,              0.02f },
+    { &K_SEMICOLON,      1, SEMICOLON_BIT,      SEMICOLON_POS,      0.02f },
+    { &K_APOSTROPHE,     1, APOSTROPHE_BIT,     APOSTROPHE_POS,     0.02f },
+    { &K_ENTER,          1, ENTER_BIT,          ENTER_POS,          0.02f },
+    { &K_KP_LEFTARROW,   2, KP_4_LEFT_BIT,      KP_4_LEFT_POS,      0.02f },
+    { &K_KP_RIGHTARROW,  2, KP_6_RIGHT_BIT,     KP_6_RIGHT_POS,     0.02f },
+    { &K_LSHIFT,         2, SHIFT_L_BIT,        SHIFT_L_POS,        0.02f },
+    { &K_Z,              2, Z_BIT,              Z_POS,              0.02f },
+    { &K_X,              2, X_BIT,              X_POS,              0.02f },
+    { &K_C,              2, C_BIT,              C_POS,              0.02f },
+    { &K_V,              2, V_BIT,              V_POS,              0.02f },
+    { &K_B,              2, B_BIT,              B_POS,              0.02f },
+    { &K_N,              2, N_BIT,              N_POS,              0.02f },
+    { &K_M,              2, M_BIT,              M_POS,              0.02f },
+    { &K_COMMA,          2, COMMA_BIT,          COMMA_POS,          0.02f },
+    { &K_PERIOD,         2, PERIOD_BIT,         PERIOD_POS,         0.02f },
+    { &K_SLASH,          2, FWRD_SLASH_BIT,     FWRD_SLASH_POS,     0.02f },
+    { &K_RSHIFT,         2, SHIFT_R_BIT,        SHIFT_R_POS,        0.02f },
+    { &K_KP_END,         2, KP_1_END_BIT,       KP_1_END_POS,       0.02f },
+    { &K_KP_DOWNARROW,   2, KP_2_DOWN_BIT,      KP_2_DOWN_POS,      0.02f },
+    { &K_KP_PGDN,        2, KP_3_PAGE_DOWN_BIT, KP_3_PAGE_DOWN_POS, 0.02f },
+    { &K_LCTRL,          2, CTRL_L_BIT,         CTRL_L_POS,         0.02f },
+    { &K_LALT,           2, ALT_L_BIT,          ALT_L_POS,          0.02f },
+    { &K_SPACE,          2, SPACE_BIT,          SPACE_POS,          0.02f },
+    { &K_RALT,           2, ALT_R_BIT,          ALT_R_POS,          0.02f },
+    { &K_RCTRL,          2, CTRL_R_BIT,         CTRL_R_POS,         0.02f },
+    { &K_LEFTARROW,      2, LEFT_BIT,           LEFT_POS,           0.02f },
+    { &K_RIGHTARROW,     2, RIGHT_BIT,          RIGHT_POS,          0.02f },
+    { &K_UPARROW,        2, UP_BIT,             UP_POS,             0.02f },
+    { &K_DOWNARROW,      2, DOWN_BIT,           DOWN_POS,           0.02f },
+    { &K_KP_INS,         2, KP_0_INSERT_BIT,    KP_0_INSERT_POS,    0.02f },
+    { &K_KP_NUMPAD_5,    2, KP_5_BEGIN_BIT,     KP_5_BEGIN_POS,     0.02f },
+    { &MOUSE_1,          2, LEFT_CLICK_BIT,     LEFT_CLICK_POS,     0.02f },
+    { &MOUSE_2,          2, RIGHT_CLICK_BIT,    RIGHT_CLICK_POS,    0.02f },
+    { &MOUSE_3,          2, MID_CLICK_BIT,      MID_CLICK_POS,      0.02f },
+    { &MOUSE_WHEEL_UP,   2, SCROLL_UP_BIT,      SCROLL_UP_POS,      0.02f },
+    { &MOUSE_WHEEL_DOWN, 3, SCROLL_DOWN_BIT,    SCROLL_DOWN_POS,    0.02f },
+};
+// clang-format on
+// BREAK_BIT and ACUTE_BIT have no InputEnum
+
+#define BUTTON_SET_COUNT 4
+
+// Bits of each set a table writes, bits outside of them keep their value like they did with per-key updates
+template<uint32_t N> constexpr uint32_t buttonTableMask(const ButtonBinding (&table)[N], uint32_t set)
+{
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < N; ++i)
+        mask |= table[i].mSet == set ? table[i].mMask : 0;
+    return mask;
+}
+
+template<uint32_t N> constexpr bool buttonTableIsValid(const ButtonBinding (&table)[N])
+{
+    for (uint32_t i = 0; i < N; ++i)
+    {
+        // One bit per button, and no two buttons of a device sharing it
+        if (table[i].mSet >= BUTTON_SET_COUNT || table[i].mMask == 0 || (table[i].mMask & (table[i].mMask - 1)) != 0)
+            return false;
+        for (uint32_t j = i + 1; j < N; ++j)
+        {
+            if (table[i].mSet == table[j].mSet && table[i].mMask == table[j].mMask)
+                return false;
+        }
+    }
+    return true;
+}
+
+COMPILE_ASSERT(buttonTableIsValid(gGamepadButtons));
+COMPILE_ASSERT(buttonTableIsValid(gKeyboardMouseButtons));
+
+// Per-frame input processing time, logged in Exit. --input-per-key switches to the per-key path for comparison.
+bool     gInputPerKey = false;
+int64_t  gInputUSec = 0;
+uint32_t gInputFrames = 0;
+
+// Reads every button of a table into one array first, then converts the values to bits four at a time
+template<uint32_t N> static void snapshotButtons(InputPortIndex port, const ButtonBinding (&table)[N], uint32_t* pButtonSets)
+{
+    const uint32_t paddedCount = (N + 3) & ~3u;
+    alignas(16) float values[paddedCount] = {};
+    for (uint32_t i = 0; i < N; ++i)
+        values[i] = inputGetValue(port, *table[i].pInput);
+
+    uint32_t pressed[BUTTON_SET_COUNT] = {};
+    for (uint32_t i = 0; i < paddedCount; i += 4)
+    {
+#if defined(BUTTON_SNAPSHOT_SSE)
+        uint32_t bits = (uint32_t)_mm_movemask_ps(_mm_cmpneq_ps(_mm_load_ps(values + i), _mm_setzero_ps()));
+#elif defined(BUTTON_SNAPSHOT_NEON)
+        static const uint32_t laneBits[4] = { 1, 2, 4, 8 };
+        uint32x4_t            isZero = vceqq_f32(vld1q_f32(values + i), vdupq_n_f32(0.0f));
+        uint32_t              bits = vaddvq_u32(vbicq_u32(vld1q_u32(laneBits), isZero));
+#else
+        uint32_t bits = 0;
+        for (uint32_t lane = 0; lane < 4; ++lane)
+            bits |= values[i + lane] != 0.0f ? 1u << lane : 0u;
+#endif
+        for (uint32_t lane = 0; bits; ++lane, bits >>= 1)
+        {
+            if (bits & 1)
+                pressed[table[i + lane].mSet] |= table[i + lane].mMask;
+        }
+    }
+
+    for (uint32_t set = 0; set < BUTTON_SET_COUNT; ++set)
+        pButtonSets[set] = (pButtonSets[set] & ~buttonTableMask(table, set)) | pressed[set];
+}
+
+// One inputGetValue() and branch per button, the way InputChecker() used to work
+template<uint32_t N> static void readButtonsPerKey(InputPortIndex port, const ButtonBinding (&table)[N], uint32_t* pButtonSets)
+{
+    for (uint32_t i = 0; i < N; ++i)
+    {
+        if (inputGetValue(port, *table[i].pInput))
+            pButtonSets[table[i].mSet] |= table[i].mMask;
+        else
+            pButtonSets[table[i].mSet] &= ~table[i].mMask;
+    }
+}
+
+template<uint32_t N> static void readButtons(InputPortIndex port, const ButtonBinding (&table)[N])
+{
+    COMPILE_ASSERT(offsetof(ConstantData, buttonSet3) == offsetof(ConstantData, buttonSet0) + 3 * sizeof(uint32_t));
+    uint32_t* pButtonSets = &gConstantData.buttonSet0;
+    if (gInputPerKey)
+        readButtonsPerKey(port, table, pButtonSets);
+    else
+        snapshotButtons(port, table, pButtonSets);
+}
+
+template<uint32_t N> static uint32_t addButtonHighlights(const ButtonBinding (&table)[N], uint32_t count)
+{
+    const uint32_t* pButtonSets = &gConstantData.buttonSet0;
+    for (uint32_t i = 0; i < N && count < gMaxHighlights; ++i)
+    {
+        if (pButtonSets[table[i].mSet] & table[i].mMask)
+            gHighlights[count++] = float4(table[i].mPos.x, table[i].mPos.y, table[i].mRadius, 0.0f);
+    }
+    return count;
+}
+
+// Compact list of circles for the current input state, drawn as instances instead of testing every button per pixel
+static uint32_t buildHighlights()
+{
+    uint32_t count = 0;
+    switch (gConstantData.deviceType)
+    {
+    case INPUT_DEVICE_GAMEPAD:
+    {
+        // Stick and trigger markers are always visible and follow the axes
+        const float scale = gAxisProjectionScale;
+        const ConstantData& data = gConstantData;
+        gHighlights[count++] =
+            float4(LEFT_STICK_POS.x + data.leftAxis.x * scale, LEFT_STICK_POS.y + data.leftAxis.y * scale, 0.01f, 0.0f);
+        gHighlights[count++] =
+            float4(RIGHT_STICK_POS.x + data.rightAxis.x * scale, RIGHT_STICK_POS.y + data.rightAxis.y * scale, 0.01f, 0.0f);
+        gHighlights[count++] = float4(BUTTON_L2_POS.x, BUTTON_L2_POS.y - data.motionButtons.x * scale, 0.02f, 0.0f);
+        gHighlights[count++] = float4(BUTTON_R2_POS.x, BUTTON_R2_POS.y - data.motionButtons.y * scale, 0.02f, 0.0f);
+        // With the button-ID mask basic.frag highlights pressed buttons itself
+        if (!data.buttonIdMask)
+            count = addButtonHighlights(gGamepadButtons, count);
+        break;
+    }
+    case INPUT_DEVICE_KBM:
+        if (!gConstantData.buttonIdMask)
+            count = addButtonHighlights(gKeyboardMouseButtons, count);
+        break;
+    }
+    return count;
+}
 
 bool InputChecker()
 {
+    const int64_t start = getUSec(true);
     switch (gConstantData.deviceType)
     {
     case INPUT_DEVICE_GAMEPAD:
@@ -317,121 +753,12 @@ bool InputChecker()
         gConstantData.rightAxis.y = -inputGetValue(gGamepadIndex, GPAD_RY);
         gConstantData.motionButtons.x = inputGetValue(gGamepadIndex, GPAD_L2);
         gConstantData.motionButtons.y = inputGetValue(gGamepadIndex, GPAD_R2);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(gGamepadIndex, GPAD_LEFT), CONTROLLER_DPAD_LEFT_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(gGamepadIndex, GPAD_RIGHT), CONTROLLER_DPAD_RIGHT_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(gGamepadIndex, GPAD_UP), CONTROLLER_DPAD_UP_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(gGamepadIndex, GPAD_DOWN), CONTROLLER_DPAD_DOWN_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(gGamepadIndex, GPAD_A), CONTROLLER_A_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(gGamepadIndex, GPAD_B), CONTROLLER_B_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(gGamepadIndex, GPAD_X), CONTROLLER_X_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(gGamepadIndex, GPAD_Y), CONTROLLER_Y_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(gGamepadIndex, GPAD_L1), CONTROLLER_L1_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(gGamepadIndex, GPAD_R1), CONTROLLER_R1_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(gGamepadIndex, GPAD_L3), CONTROLLER_L3_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(gGamepadIndex, GPAD_R3), CONTROLLER_R3_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(gGamepadIndex, GPAD_START), CONTROLLER_START_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(gGamepadIndex, GPAD_BACK), CONTROLLER_SELECT_BIT);
+        readButtons(gGamepadIndex, gGamepadButtons);
         break;
     }
     case INPUT_DEVICE_KBM:
     {
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(0, K_ESCAPE), ESCAPE_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(0, K_F1), F1_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(0, K_F2), F2_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(0, K_F3), F3_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(0, K_F4), F4_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(0, K_F5), F5_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(0, K_F6), F6_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(0, K_F7), F7_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(0, K_F8), F8_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(0, K_F9), F9_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(0, K_F10), F10_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(0, K_F11), F11_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(0, K_F12), F12_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(0, K_INS), INSERT_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(0, K_DEL), DEL_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(0, K_KP_NUMLOCK), NUM_LOCK_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(0, K_KP_STAR), KP_MULTIPLY_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(0, K_1), NUM_1_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(0, K_2), NUM_2_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(0, K_3), NUM_3_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(0, K_4), NUM_4_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(0, K_5), NUM_5_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(0, K_6), NUM_6_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(0, K_7), NUM_7_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(0, K_8), NUM_8_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(0, K_9), NUM_9_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(0, K_0), NUM_0_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(0, K_MINUS), MINUS_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(0, K_EQUAL), EQUAL_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet0, inputGetValue(0, K_BACKSPACE), BACK_SPACE_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet1, inputGetValue(0, K_KP_PLUS), KP_ADD_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet1, inputGetValue(0, K_KP_MINUS), KP_SUBTRACT_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet1, inputGetValue(0, K_TAB), TAB_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet1, inputGetValue(0, K_Q), Q_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet1, inputGetValue(0, K_W), W_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet1, inputGetValue(0, K_E), E_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet1, inputGetValue(0, K_R), R_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet1, inputGetValue(0, K_T), T_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet1, inputGetValue(0, K_Y), Y_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet1, inputGetValue(0, K_U), U_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet1, inputGetValue(0, K_I), I_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet1, inputGetValue(0, K_O), O_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet1, inputGetValue(0, K_P), P_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet1, inputGetValue(0, K_LEFTBRACKET), BRACKET_LEFT_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet1, inputGetValue(0, K_RIGHTBRACKET), BRACKET_RIGHT_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet1, inputGetValue(0, K_BACKSLASH), BACK_SLASH_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet1, inputGetValue(0, K_KP_HOME), KP_7_HOME_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet1, inputGetValue(0, K_KP_UPARROW), KP_8_UP_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet1, inputGetValue(0, K_KP_PGUP), KP_9_PAGE_UP_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet1, inputGetValue(0, K_CAPSLOCK), CAPS_LOCK_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet1, inputGetValue(0, K_A), A_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet1, inputGetValue(0, K_S), S_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet1, inputGetValue(0, K_D), D_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet1, inputGetValue(0, K_F), F_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet1, inputGetValue(0, K_G), G_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet1, inputGetValue(0, K_H), H_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet1, inputGetValue(0, K_J), J_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet1, inputGetValue(0, K_K), K_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet1, inputGetValue(0, K_L), L_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet1, inputGetValue(0, K_SEMICOLON), SEMICOLON_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet1, inputGetValue(0, K_APOSTROPHE), APOSTROPHE_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet1, inputGetValue(0, K_ENTER), ENTER_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet2, inputGetValue(0, K_KP_LEFTARROW), KP_4_LEFT_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet2, inputGetValue(0, K_KP_RIGHTARROW), KP_6_RIGHT_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet2, inputGetValue(0, K_LSHIFT), SHIFT_L_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet2, inputGetValue(0, K_Z), Z_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet2, inputGetValue(0, K_X), X_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet2, inputGetValue(0, K_C), C_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet2, inputGetValue(0, K_V), V_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet2, inputGetValue(0, K_B), B_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet2, inputGetValue(0, K_N), N_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet2, inputGetValue(0, K_M), M_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet2, inputGetValue(0, K_COMMA), COMMA_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet2, inputGetValue(0, K_PERIOD), PERIOD_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet2, inputGetValue(0, K_SLASH), FWRD_SLASH_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet2, inputGetValue(0, K_RSHIFT), SHIFT_R_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet2, inputGetValue(0, K_KP_END), KP_1_END_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet2, inputGetValue(0, K_KP_DOWNARROW), KP_2_DOWN_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet2, inputGetValue(0, K_KP_PGDN), KP_3_PAGE_DOWN_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet2, inputGetValue(0, K_LCTRL), CTRL_L_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet2, inputGetValue(0, K_LALT), ALT_L_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet2, inputGetValue(0, K_SPACE), SPACE_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet2, inputGetValue(0, K_RALT), ALT_R_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet2, inputGetValue(0, K_RCTRL), CTRL_R_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet2, inputGetValue(0, K_LEFTARROW), LEFT_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet2, inputGetValue(0, K_RIGHTARROW), RIGHT_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet2, inputGetValue(0, K_UPARROW), UP_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet2, inputGetValue(0, K_DOWNARROW), DOWN_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet2, inputGetValue(0, K_KP_INS), KP_0_INSERT_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet2, inputGetValue(0, K_KP_NUMPAD_5), KP_5_BEGIN_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet2, inputGetValue(0, MOUSE_1), LEFT_CLICK_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet2, inputGetValue(0, MOUSE_2), RIGHT_CLICK_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet2, inputGetValue(0, MOUSE_3), MID_CLICK_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet2, inputGetValue(0, MOUSE_WHEEL_UP), SCROLL_UP_BIT);
-        SET_BUTTON_BIT(gConstantData.buttonSet3, inputGetValue(0, MOUSE_WHEEL_DOWN), SCROLL_DOWN_BIT);
-        // SET_BUTTON_BIT(gConstantData.buttonSet0, ctx->mBool, BREAK_BIT);
-        // SET_BUTTON_BIT(gConstantData.buttonSet0, ctx->mBool, ACUTE_BIT);
+        readButtons(0, gKeyboardMouseButtons);
         break;
     }
 #if defined(ENABLE_FORGE_TOUCH_INPUT)
@@ -439,39 +766,308 @@ bool InputChecker()
         break;
 #endif
     }
+    gInputUSec += getUSec(true) - start;
+    ++gInputFrames;
 
     return true;
 };
 
-IApp* gUnitTestApp = NULL;
+// Input-to-present latency. An input change is stamped when InputChecker() first sees it (the sample that saw it with
+// --input-sampling, touch events when their callback arrives), the frame that uploads it is tagged, and the sample
+// completes once that frame's fence is seen signaled. The input layer polls the OS right before Update(), so the stamp
+// can trail the OS event by up to a frame.
+struct LatencySample
+{
+    uint32_t mFrame;
+    int64_t  mInputUSec;
+    int64_t  mSubmitUSec;
+    int64_t  mPresentUSec;
+    int64_t  mGpuDoneUSec;
+};
 
-void OnDeviceSwitch(void* pUserData)
+struct LatencyFrame
 {
-    UNREF_PARAM(pUserData);
-    waitQueueIdle(pGraphicsQueue);
-    gConstantData.deviceType = gChosenDeviceType;
+    Fence*        pFence; // NULL when the frame carries no input change
+    LatencySample mSample;
+};
 
-    switch (gConstantData.deviceType)
+const uint32_t       gMaxLatencySamples = 4096;
+LatencySample        gLatencySamples[gMaxLatencySamples] = {};
+uint32_t             gLatencySampleCount = 0;
+LatencyFrame         gLatencyFrames[gDataBufferCount] = {};
+int64_t              gPendingInputUSec = 0; // Oldest input change not uploaded yet, 0 if none
+uint32_t             gFrameCount = 0;
+static unsigned char gLatencyCharArray[256] = {};
+static bstring       gLatencyText = bfromarr(gLatencyCharArray);
+
+static void stampInputChange(int64_t usec)
+{
+    if (!gPendingInputUSec)
+        gPendingInputUSec = usec;
+}
+
+// Percentiles of one latency column in ms. Runs on the frame thread every 16 samples, so it copies the column and
+// sorts it in O(n log n) rather than inserting into a sorted array.
+static Percentiles getLatencyPercentiles(int64_t LatencySample::*pEnd, float* pScratch, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i)
+        pScratch[i] = (gLatencySamples[i].*pEnd - gLatencySamples[i].mInputUSec) / 1000.0f;
+    return getPercentiles(pScratch, count);
+}
+
+static void updateLatencyText()
+{
+    static float   scratch[gMaxLatencySamples];
+    const uint32_t count = min(gLatencySampleCount, gMaxLatencySamples);
+    const char*    labels[] = { "Input to submit:   ", "Input to present:  ", "Input to GPU done: " };
+    int64_t LatencySample::*ends[] = { &LatencySample::mSubmitUSec, &LatencySample::mPresentUSec, &LatencySample::mGpuDoneUSec };
+
+    bassigncstr(&gLatencyText, "\n");
+    for (uint32_t i = 0; count && i < TF_ARRAY_COUNT(ends); ++i)
     {
-    case INPUT_DEVICE_GAMEPAD:
+        const Percentiles p = getLatencyPercentiles(ends[i], scratch, count);
+        bformata(&gLatencyText, "    %sp50 %.2f ms, p95 %.2f ms, p99 %.2f ms, max %.2f ms\n", labels[i], p.mP50, p.mP95, p.mP99, p.mMax);
+    }
+    bformata(&gLatencyText, "    Samples: %u\n", count);
+}
+
+static void completeLatencyFrame(LatencyFrame* pFrame, int64_t now)
+{
+    pFrame->mSample.mGpuDoneUSec = now;
+    gLatencySamples[gLatencySampleCount % gMaxLatencySamples] = pFrame->mSample;
+    pFrame->pFence = NULL;
+    if (++gLatencySampleCount % 16 == 0)
+        updateLatencyText();
+}
+
+static void dumpLatencyCsv(void*)
+{
+    const char* fileName = "34_Input_Latency.csv";
+    FileStream  stream = {};
+    if (!fsOpenStreamFromPath(RD_LOG, fileName, FM_WRITE, &stream))
     {
-        pInputDeviceTexture = pGamepad;
-        break;
+        LOGF(LogLevel::eERROR, "Could not open %s for writing", fileName);
+        return;
     }
-    case INPUT_DEVICE_KBM:
+
+    fsPrintToStream(&stream, "frame,input_us,to_submit_ms,to_present_ms,to_gpu_done_ms\n");
+    const uint32_t count = min(gLatencySampleCount, gMaxLatencySamples);
+    const uint32_t oldest = gLatencySampleCount - count;
+    for (uint32_t i = 0; i < count; ++i)
     {
-        pInputDeviceTexture = pKeyboardMouse;
-        break;
+        const LatencySample& sample = gLatencySamples[(oldest + i) % gMaxLatencySamples];
+        fsPrintToStream(&stream, "%u,%lld,%.3f,%.3f,%.3f\n", sample.mFrame, (long long)sample.mInputUSec,
+                        (sample.mSubmitUSec - sample.mInputUSec) / 1000.0f, (sample.mPresentUSec - sample.mInputUSec) / 1000.0f,
+                        (sample.mGpuDoneUSec - sample.mInputUSec) / 1000.0f);
     }
-#if defined(ENABLE_FORGE_TOUCH_INPUT)
-    case INPUT_DEVICE_TOUCH:
+    fsCloseStream(&stream);
+    LOGF(LogLevel::eINFO, "Wrote %u input latency samples to %s", count, fileName);
+}
+
+// Optional input sampling (--input-sampling). The platform pumps the OS events on the main thread right before every
+// Update(), including the passes on-demand rendering skips, so Update() pushes one timestamped sample per pump into
+// gInputSamples. The ring is drained by the next rendered frame: presses shorter than a frame still reach the shader,
+// presses are counted and mouse motion is integrated per rendered frame. While idle the pump runs every
+// gInputSampleSleepMs instead of gIdleSleepMs. With continuous rendering there is one pump, so one sample, per frame.
+struct InputSample
+{
+    int64_t  mUSec;
+    uint32_t mDeviceType;
+    uint32_t mButtonSets[BUTTON_SET_COUNT];
+    float    mAxes[6]; // left x/y, right x/y, L2, R2
+    float    mMouse[2];
+};
+
+const uint32_t              gInputSampleSleepMs = 1;
+SpscRing<InputSample, 1024> gInputSamples = {};
+bool                        gInputSampling = false;
+uint32_t                    gInputSampleDrops = 0;
+InputSample                 gLastPushedSample = {};
+InputSample                 gLastInputSample = {};
+bool                        gLastInputSampleValid = false;
+uint32_t                    gInputPresses = 0;
+uint32_t                    gInputSubFramePresses = 0;
+float2                      gMouseDelta = float2(0.0f, 0.0f);
+static unsigned char        gInputSamplingCharArray[256] = {};
+static bstring              gInputSamplingText = bfromarr(gInputSamplingCharArray);
+
+static uint32_t countBits(uint32_t bits)
+{
+    uint32_t count = 0;
+    for (; bits; bits &= bits - 1)
+        ++count;
+    return count;
+}
+
+// Producer, once per pump. A sample that differs from the previous one renders a frame to consume it.
+static void sampleInput()
+{
+    InputSample sample = {};
+    sample.mUSec = getUSec(true);
+    sample.mDeviceType = gConstantData.deviceType;
+    if (sample.mDeviceType == INPUT_DEVICE_GAMEPAD)
     {
-        break;
+        sample.mAxes[0] = inputGetValue(gGamepadIndex, GPAD_LX);
+        sample.mAxes[1] = -inputGetValue(gGamepadIndex, GPAD_LY);
+        sample.mAxes[2] = inputGetValue(gGamepadIndex, GPAD_RX);
+        sample.mAxes[3] = -inputGetValue(gGamepadIndex, GPAD_RY);
+        sample.mAxes[4] = inputGetValue(gGamepadIndex, GPAD_L2);
+        sample.mAxes[5] = inputGetValue(gGamepadIndex, GPAD_R2);
+        snapshotButtons(gGamepadIndex, gGamepadButtons, sample.mButtonSets);
     }
-#endif
+    else if (sample.mDeviceType == INPUT_DEVICE_KBM)
+    {
+        sample.mMouse[0] = inputGetValue(0, MOUSE_X);
+        sample.mMouse[1] = inputGetValue(0, MOUSE_Y);
+        snapshotButtons(0, gKeyboardMouseButtons, sample.mButtonSets);
+    }
+    if (!spscPush(&gInputSamples, sample))
+        ++gInputSampleDrops;
+
+    const size_t stateSize = offsetof(InputSample, mMouse) + sizeof(sample.mMouse) - offsetof(InputSample, mDeviceType);
+    if (memcmp(&sample.mDeviceType, &gLastPushedSample.mDeviceType, stateSize) != 0)
+        gRedrawFrames = gRedrawFrameCount;
+    gLastPushedSample = sample;
+}
+
+// Consumer, replaces InputChecker() on the passes that render a frame
+static void consumeInputSamples()
+{
+    const uint32_t* pHeldAtStart = gLastInputSample.mButtonSets;
+    uint32_t        heldAtStart[BUTTON_SET_COUNT] = { pHeldAtStart[0], pHeldAtStart[1], pHeldAtStart[2], pHeldAtStart[3] };
+    uint32_t        seen[BUTTON_SET_COUNT] = {};
+    uint32_t        count = 0;
+    InputSample     sample;
+    gMouseDelta = float2(0.0f, 0.0f);
+    while (spscPop(&gInputSamples, &sample))
+    {
+        // Samples taken before a device switch
+        if (sample.mDeviceType != gConstantData.deviceType)
+        {
+            gLastInputSampleValid = false;
+            continue;
+        }
+
+        bool changed = !gLastInputSampleValid;
+        for (uint32_t set = 0; set < BUTTON_SET_COUNT; ++set)
+        {
+            const uint32_t previous = gLastInputSampleValid ? gLastInputSample.mButtonSets[set] : 0;
+            gInputPresses += countBits(sample.mButtonSets[set] & ~previous);
+            seen[set] |= sample.mButtonSets[set];
+            changed |= sample.mButtonSets[set] != previous;
+        }
+        changed |= memcmp(sample.mAxes, gLastInputSample.mAxes, sizeof(sample.mAxes)) != 0;
+        if (gLastInputSampleValid)
+        {
+            gMouseDelta.x += sample.mMouse[0] - gLastInputSample.mMouse[0];
+            gMouseDelta.y += sample.mMouse[1] - gLastInputSample.mMouse[1];
+        }
+        if (changed)
+            stampInputChange(sample.mUSec);
+
+        gLastInputSample = sample;
+        gLastInputSampleValid = true;
+        ++count;
+    }
+    if (!count)
+        return;
+
+    // A button is shown in every frame it was down in, even if it was released again before the frame
+    uint32_t* pButtonSets = &gConstantData.buttonSet0;
+    for (uint32_t set = 0; set < BUTTON_SET_COUNT; ++set)
+    {
+        pButtonSets[set] = seen[set] | gLastInputSample.mButtonSets[set];
+        gInputSubFramePresses += countBits(seen[set] & ~heldAtStart[set] & ~gLastInputSample.mButtonSets[set]);
+    }
+    if (gConstantData.deviceType == INPUT_DEVICE_GAMEPAD)
+    {
+        gConstantData.leftAxis = float2(gLastInputSample.mAxes[0], gLastInputSample.mAxes[1]);
+        gConstantData.rightAxis = float2(gLastInputSample.mAxes[2], gLastInputSample.mAxes[3]);
+        gConstantData.motionButtons = float2(gLastInputSample.mAxes[4], gLastInputSample.mAxes[5]);
     }
+    bformat(&gInputSamplingText,
+            "\n"
+            "    Samples this frame: %u\n"
+            "    Presses:            %u (%u within one frame)\n"
+            "    Mouse delta:        %.0f, %.0f\n"
+            "    Dropped:            %u\n",
+            count, gInputPresses, gInputSubFramePresses, gMouseDelta.x, gMouseDelta.y, gInputSampleDrops);
+}
+
+IApp* gUnitTestApp = NULL;
+
+void OnDeviceSwitch(void* pUserData)
+{
+    UNREF_PARAM(pUserData);
+    // Frames in flight keep their own constants and descriptor set index, nothing on the GPU needs to drain
+    gConstantData.deviceType = gChosenDeviceType;
 };
 
+// Touch has no device texture, its shader path samples nothing so any set will do
+static uint32_t getDeviceDescriptorIndex() { return gConstantData.deviceType < gDeviceDescriptorCount ? gConstantData.deviceType : 0; }
+
+void OnTraceCaptureRequested(void* pUserData)
+{
+    UNREF_PARAM(pUserData);
+    requestTraceCapture(gTraceFrameCount);
+}
+
+// Per-port gamepad state, refreshed only when a port connects or disconnects. IInput has no hotplug callback, so
+// updateGamepadRegistry() compares the connected mask once per frame and only then touches names and strings.
+struct GamepadInfo
+{
+    char mLabel[FS_MAX_PATH]; // Dropdown entry, the UI keeps pointing at it
+    bool mConnected;
+};
+
+struct GamepadRegistry
+{
+    GamepadInfo mPorts[MAX_GAMEPADS];
+    uint32_t    mConnectedMask;
+};
+
+GamepadRegistry gGamepads = {};
+
+static void refreshGamepadPort(uint32_t port)
+{
+    GamepadInfo& info = gGamepads.mPorts[port];
+    info.mConnected = inputGamepadIsActive(port);
+    snprintf(info.mLabel, TF_ARRAY_COUNT(info.mLabel), "Gamepad[%u] %s", port, info.mConnected ? inputGamepadName(port) : "Not connected");
+}
+
+// Everything starts disconnected, the first updateGamepadRegistry() picks up the gamepads that are already attached
+static void initGamepadRegistry()
+{
+    gGamepads.mConnectedMask = 0;
+    for (uint32_t i = 0; i < MAX_GAMEPADS; ++i)
+    {
+        gGamepads.mPorts[i].mConnected = false;
+        snprintf(gGamepads.mPorts[i].mLabel, TF_ARRAY_COUNT(gGamepads.mPorts[i].mLabel), "Gamepad[%u] Not connected", i);
+    }
+}
+
+// Returns true if a gamepad connected or disconnected since the last call
+static bool updateGamepadRegistry()
+{
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < MAX_GAMEPADS; ++i)
+        mask |= inputGamepadIsActive(i) ? 1u << i : 0u;
+
+    uint32_t changed = mask ^ gGamepads.mConnectedMask;
+    if (!changed)
+        return false;
+
+    for (uint32_t i = 0; changed; ++i, changed >>= 1)
+    {
+        if (!(changed & 1))
+            continue;
+        refreshGamepadPort(i);
+        LOGF(LogLevel::eINFO, "Gamepad[%u] %s", i, gGamepads.mPorts[i].mConnected ? "connected" : "disconnected");
+    }
+    gGamepads.mConnectedMask = mask;
+    return true;
+}
+
 void OnLightsAndRumbleSwitch(void* pUserData)
 {
     UNREF_PARAM(pUserData);
@@ -484,6 +1080,9 @@ void OnLightsAndRumbleSwitch(void* pUserData)
 
 void DoRumbleAndLightsTestSequence(float deltaTime)
 {
+    if (!(gGamepads.mConnectedMask & (1u << gGamepadIndex)))
+        return;
+
     static float total = 0.0f;
     const float  threshold = 1.0f;
     total += deltaTime;
@@ -501,43 +1100,190 @@ void DoRumbleAndLightsTestSequence(float deltaTime)
     }
 }
 
+// --record-input / --replay-input: the chosen device and gamepad, the device state InputChecker() or
+// consumeInputSamples() produced from them, plus touch events
+enum InputChannel
+{
+    INPUT_CHANNEL_DEVICE_TYPE,
+    INPUT_CHANNEL_GAMEPAD_INDEX,
+    INPUT_CHANNEL_LEFT_X,
+    INPUT_CHANNEL_LEFT_Y,
+    INPUT_CHANNEL_RIGHT_X,
+    INPUT_CHANNEL_RIGHT_Y,
+    INPUT_CHANNEL_MOTION_X,
+    INPUT_CHANNEL_MOTION_Y,
+    INPUT_CHANNEL_BUTTON_SET0,
+    INPUT_CHANNEL_COUNT = INPUT_CHANNEL_BUTTON_SET0 + BUTTON_SET_COUNT
+};
+
+InputRecordArgs gInputRecordArgs = {};
+InputRecorder   gInputRecorder = {};
+
+// Runs before InputChecker(), which reads the device and gamepad this selects, so a replay applies the recorded
+// button sets to the device they were recorded from
+static void recordInputDevice()
+{
+    InputRecorder* pRec = &gInputRecorder;
+    gConstantData.deviceType = inputRecordBits(pRec, INPUT_CHANNEL_DEVICE_TYPE, gConstantData.deviceType);
+    gGamepadIndex = (InputPortIndex)inputRecordBits(pRec, INPUT_CHANNEL_GAMEPAD_INDEX, (uint32_t)gGamepadIndex);
+    // Keeps the dropdown in sync with what a replay selected
+    if (pRec->mMode == INPUT_RECORD_REPLAY)
+        gChosenDeviceType = gConstantData.deviceType;
+}
+
+static void recordInputState()
+{
+    InputRecorder* pRec = &gInputRecorder;
+    gConstantData.leftAxis.x = inputRecordFloat(pRec, INPUT_CHANNEL_LEFT_X, gConstantData.leftAxis.x);
+    gConstantData.leftAxis.y = inputRecordFloat(pRec, INPUT_CHANNEL_LEFT_Y, gConstantData.leftAxis.y);
+    gConstantData.rightAxis.x = inputRecordFloat(pRec, INPUT_CHANNEL_RIGHT_X, gConstantData.rightAxis.x);
+    gConstantData.rightAxis.y = inputRecordFloat(pRec, INPUT_CHANNEL_RIGHT_Y, gConstantData.rightAxis.y);
+    gConstantData.motionButtons.x = inputRecordFloat(pRec, INPUT_CHANNEL_MOTION_X, gConstantData.motionButtons.x);
+    gConstantData.motionButtons.y = inputRecordFloat(pRec, INPUT_CHANNEL_MOTION_Y, gConstantData.motionButtons.y);
+    uint32_t* pButtonSets = &gConstantData.buttonSet0;
+    for (uint32_t set = 0; set < BUTTON_SET_COUNT; ++set)
+        pButtonSets[set] = inputRecordBits(pRec, INPUT_CHANNEL_BUTTON_SET0 + set, pButtonSets[set]);
+}
+
 #if defined(ENABLE_FORGE_TOUCH_INPUT)
+// OnTouchEvent() runs on the OS callback thread and only pushes into gTouchEvents. The frame drains the queue once in
+// Update into gTouches, which Draw reads without racing the callback. gTouchSlots maps a touch ID to its gTouches
+// slot (open addressing with linear probing), so a move or end event does not scan every contact.
+struct TouchEventSample
+{
+    TouchEvent mEvent;
+    int64_t    mUSec;
+};
+
+const uint32_t gMaxTouches = 256;
+const uint32_t gTouchSlotBits = 9; // Twice gMaxTouches keeps probe sequences short
+const uint32_t gTouchSlotCount = 1u << gTouchSlotBits;
+
+struct TouchSlot
+{
+    int32_t  mId;
+    uint32_t mSlot;
+};
+
+SpscRing<TouchEventSample, 1024> gTouchEvents = {};
+tfrg_atomic32_t                  gTouchEventDrops = 0;
+TouchEvent                       gTouches[gMaxTouches] = {};
+uint32_t                         gTouchCount = 0;
+TouchSlot                        gTouchSlots[gTouchSlotCount] = {};
+
+static uint32_t touchSlotHash(int32_t id) { return ((uint32_t)id * 2654435761u) >> (32 - gTouchSlotBits); }
+
+static TouchSlot* findTouchSlot(int32_t id)
+{
+    for (uint32_t i = touchSlotHash(id);; i = (i + 1) & (gTouchSlotCount - 1))
+    {
+        if (gTouchSlots[i].mId == id)
+            return &gTouchSlots[i];
+        if (gTouchSlots[i].mId == TOUCH_ID_INVALID)
+            return NULL;
+    }
+}
+
+static void insertTouchSlot(int32_t id, uint32_t slot)
+{
+    uint32_t i = touchSlotHash(id);
+    while (gTouchSlots[i].mId != TOUCH_ID_INVALID)
+        i = (i + 1) & (gTouchSlotCount - 1);
+    gTouchSlots[i] = { id, slot };
+}
+
+static void removeTouchSlot(TouchSlot* pSlot)
+{
+    // Backward shift deletion: pull later entries of the probe sequence into the hole so lookups never stop early
+    uint32_t hole = (uint32_t)(pSlot - gTouchSlots);
+    for (uint32_t i = (hole + 1) & (gTouchSlotCount - 1); gTouchSlots[i].mId != TOUCH_ID_INVALID; i = (i + 1) & (gTouchSlotCount - 1))
+    {
+        const uint32_t home = touchSlotHash(gTouchSlots[i].mId);
+        if (((i - home) & (gTouchSlotCount - 1)) >= ((i - hole) & (gTouchSlotCount - 1)))
+        {
+            gTouchSlots[hole] = gTouchSlots[i];
+            hole = i;
+        }
+    }
+    gTouchSlots[hole].mId = TOUCH_ID_INVALID;
+}
+
+static void resetTouches()
+{
+    for (uint32_t i = 0; i < gTouchSlotCount; ++i)
+        gTouchSlots[i].mId = TOUCH_ID_INVALID;
+    gTouchCount = 0;
+}
+
 static void OnTouchEvent(const TouchEvent* event, void* pData)
 {
     UNREF_PARAM(pData);
-    if (TOUCH_BEGAN == event->mPhase)
+    if (!spscPush(&gTouchEvents, TouchEventSample{ *event, getUSec(true) }))
+        tfrg_atomic32_add_relaxed(&gTouchEventDrops, 1);
+}
+
+static bool applyTouchEvent(const TouchEvent& event)
+{
+    TouchSlot* pSlot = findTouchSlot(event.mId);
+    if (TOUCH_BEGAN == event.mPhase || TOUCH_MOVED == event.mPhase)
     {
-        for (uint32_t t = 0; t < TF_ARRAY_COUNT(gTouches); ++t)
+        if (pSlot)
         {
-            if (TOUCH_ID_INVALID == gTouches[t].mId)
-            {
-                gTouches[t] = *event;
-                break;
-            }
+            gTouches[pSlot->mSlot] = event;
+        }
+        else if (TOUCH_BEGAN == event.mPhase && gTouchCount < gMaxTouches)
+        {
+            insertTouchSlot(event.mId, gTouchCount);
+            gTouches[gTouchCount++] = event;
+        }
+        else
+        {
+            return false;
         }
     }
-    else if (TOUCH_MOVED == event->mPhase)
+    else
     {
-        for (uint32_t t = 0; t < TF_ARRAY_COUNT(gTouches); ++t)
+        if (!pSlot)
+            return false;
+        // Swap the last contact into the freed slot to keep gTouches dense
+        const uint32_t slot = pSlot->mSlot;
+        removeTouchSlot(pSlot);
+        if (slot != --gTouchCount)
         {
-            if (event->mId == gTouches[t].mId)
-            {
-                gTouches[t] = *event;
-                break;
-            }
+            gTouches[slot] = gTouches[gTouchCount];
+            findTouchSlot(gTouches[slot].mId)->mSlot = slot;
         }
     }
-    else
+    return true;
+}
+
+// Applies the queued events (or the recorded ones during replay) to gTouches, returns true if the snapshot changed
+static bool consumeTouchEvents()
+{
+    bool             changed = false;
+    TouchEventSample sample;
+    while (spscPop(&gTouchEvents, &sample))
     {
-        for (uint32_t t = 0; t < TF_ARRAY_COUNT(gTouches); ++t)
+        if (gInputRecorder.mMode == INPUT_RECORD_REPLAY)
+            continue;
+        inputRecordEvent(&gInputRecorder, &sample.mEvent);
+        if (applyTouchEvent(sample.mEvent))
         {
-            if (event->mId == gTouches[t].mId)
-            {
-                gTouches[t].mId = TOUCH_ID_INVALID;
-                break;
-            }
+            stampInputChange(sample.mUSec);
+            changed = true;
+        }
+    }
+
+    TouchEvent event;
+    while (inputRecordNextEvent(&gInputRecorder, &event))
+    {
+        if (applyTouchEvent(event))
+        {
+            stampInputChange(getUSec(true));
+            changed = true;
         }
     }
+    return changed;
 }
 #endif
 
@@ -557,6 +1303,35 @@ public:
 
     bool Init()
     {
+        InitTimeline timeline;
+        initTimelineBegin(&timeline);
+
+        for (int i = 1; i < argc; ++i)
+        {
+            if (strcmp(argv[i], "--input-per-key") == 0)
+                gInputPerKey = true;
+            else if (strcmp(argv[i], "--on-demand") == 0)
+                gOnDemandRendering = true;
+            else if (strcmp(argv[i], "--input-sampling") == 0)
+                gInputSampling = true;
+            else if (strcmp(argv[i], "--button-id-mask") == 0)
+                gButtonIdMask = true;
+            else if (strcmp(argv[i], "--input-bindings-per-line") == 0)
+                gInputBindingsPerLine = true;
+            else if (strcmp(argv[i], "--input-bindings-check") == 0)
+                gInputBindingsCheck = true;
+            else
+                inputRecordParseArg(argc, argv, &i, &gInputRecordArgs);
+        }
+#if defined(ENABLE_FORGE_TOUCH_INPUT)
+        const uint32_t recordEventSize = sizeof(TouchEvent);
+#else
+        const uint32_t recordEventSize = 0;
+#endif
+        if (!initInputRecorder(&gInputRecorder, gInputRecordArgs.mMode, gInputRecordArgs.pFileName, INPUT_CHANNEL_COUNT,
+                               recordEventSize, gInputRecordArgs.mFixedDeltaTime))
+            return false;
+
         // window and renderer setup
         RendererDesc settings;
         memset(&settings, 0, sizeof(settings));
@@ -569,6 +1344,7 @@ public:
             return false;
         }
         setupGPUConfigurationPlatformParameters(pRenderer, settings.pExtendedSettings);
+        initTimelineMark(&timeline, "renderer");
 
         QueueDesc queueDesc = {};
         queueDesc.mType = QUEUE_TYPE_GRAPHICS;
@@ -583,13 +1359,13 @@ public:
         initGpuCmdRing(pRenderer, &cmdRingDesc, &gGraphicsCmdRing);
 
         initSemaphore(pRenderer, &pImageAcquiredSemaphore);
+        initTraceCapture(pRenderer, pGraphicsQueue, GetName());
+        initTimelineMark(&timeline, "queues");
 
         initResourceLoaderInterface(pRenderer);
 
-        RootSignatureDesc rootDesc = {};
-        INIT_RS_DESC(rootDesc, "default.rootsig", "compute.rootsig");
-        initRootSignature(pRenderer, &rootDesc);
-
+        // Issue the file loads first, the loader reads and uploads them while the rest of Init runs.
+        // Nothing below needs the textures until the waitForAllResourceLoads() at the end.
         TextureLoadDesc textureDesc = {};
         textureDesc.pFileName = "input/controller.tex";
         textureDesc.ppTexture = &pGamepad;
@@ -599,6 +1375,51 @@ public:
         textureDesc.ppTexture = &pKeyboardMouse;
         addResource(&textureDesc, NULL);
 
+        gButtonIdMaskAvailable =
+            fsFileExist(RD_TEXTURES, "input/controller_ids.tex") && fsFileExist(RD_TEXTURES, "input/keyboard+mouse_ids.tex");
+        if (gButtonIdMaskAvailable)
+        {
+            textureDesc.pFileName = "input/controller_ids.tex";
+            textureDesc.ppTexture = &pGamepadIds;
+            addResource(&textureDesc, NULL);
+
+            textureDesc.pFileName = "input/keyboard+mouse_ids.tex";
+            textureDesc.ppTexture = &pKeyboardMouseIds;
+            addResource(&textureDesc, NULL);
+        }
+        else
+        {
+            LOGF(LogLevel::eINFO, "No baked button-ID masks, --button-id-mask is ignored");
+            TextureDesc placeholderDesc = {};
+            placeholderDesc.mWidth = 1;
+            placeholderDesc.mHeight = 1;
+            placeholderDesc.mDepth = 1;
+            placeholderDesc.mArraySize = 1;
+            placeholderDesc.mMipLevels = 1;
+            placeholderDesc.mFormat = TinyImageFormat_R8_UINT;
+            placeholderDesc.mSampleCount = SAMPLE_COUNT_1;
+            placeholderDesc.mDescriptors = DESCRIPTOR_TYPE_TEXTURE;
+            placeholderDesc.mStartState = RESOURCE_STATE_SHADER_RESOURCE;
+            placeholderDesc.pName = "Button ID Placeholder";
+            TextureLoadDesc placeholderLoadDesc = {};
+            placeholderLoadDesc.pDesc = &placeholderDesc;
+            placeholderLoadDesc.ppTexture = &pGamepadIds;
+            addResource(&placeholderLoadDesc, NULL);
+            pKeyboardMouseIds = pGamepadIds;
+        }
+        initTimelineMark(&timeline, "textures (issue)");
+
+        getPipelineCacheName(pRenderer, GetName(), gPipelineCacheName, TF_ARRAY_COUNT(gPipelineCacheName));
+        gPipelineCacheWarm = fsFileExist(RD_PIPELINE_CACHE, gPipelineCacheName);
+        PipelineCacheLoadDesc cacheDesc = {};
+        cacheDesc.pFileName = gPipelineCacheName;
+        loadPipelineCache(pRenderer, &cacheDesc, &pPipelineCache);
+
+        RootSignatureDesc rootDesc = {};
+        INIT_RS_DESC(rootDesc, "default.rootsig", "compute.rootsig");
+        initRootSignature(pRenderer, &rootDesc);
+        initTimelineMark(&timeline, "root signature");
+
         BufferLoadDesc bufferDesc = {};
         bufferDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_UNIFORM_BUFFER;
         bufferDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
@@ -611,6 +1432,21 @@ public:
             addResource(&bufferDesc, NULL);
         }
 
+        BufferLoadDesc highlightDesc = {};
+        highlightDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_BUFFER;
+        highlightDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
+        highlightDesc.mDesc.mFlags = BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT;
+        highlightDesc.mDesc.mFormat = TinyImageFormat_R32G32B32A32_SFLOAT;
+        highlightDesc.mDesc.mElementCount = gMaxHighlights;
+        highlightDesc.mDesc.mStructStride = sizeof(float4);
+        highlightDesc.mDesc.mSize = gMaxHighlights * sizeof(float4);
+        highlightDesc.pData = NULL;
+        for (uint32_t i = 0; i < gDataBufferCount; ++i)
+        {
+            highlightDesc.ppBuffer = &pHighlightBuffer[i];
+            addResource(&highlightDesc, NULL);
+        }
+
         // Load fonts
         FontDesc font = {};
         font.pFontPath = "TitilliumText/TitilliumText-Bold.otf";
@@ -620,6 +1456,7 @@ public:
         fontRenderDesc.pRenderer = pRenderer;
         if (!initFontSystem(&fontRenderDesc))
             return false; // report?
+        initTimelineMark(&timeline, "fonts");
 
         gQuadVerts[0].mPosition = { 1.0f, 1.0f, 0.0f, 1.0f };
         gQuadVerts[0].mTexcoord = { 1.0f, 0.0f };
@@ -652,6 +1489,7 @@ public:
         UserInterfaceDesc uiRenderDesc = {};
         uiRenderDesc.pRenderer = pRenderer;
         initUserInterface(&uiRenderDesc);
+        initTimelineMark(&timeline, "ui");
 
         // Initialize micro profiler and its UI.
         ProfilerDesc profiler = {};
@@ -660,37 +1498,55 @@ public:
 
         // Gpu profiler can only be added after initProfiler.
         gGpuProfileToken = initGpuProfiler(pRenderer, pGraphicsQueue, "Graphics");
-
-        // Setup action mappings and callbacks
-        OnDeviceSwitch(nullptr);
-
-        waitForAllResourceLoads();
+        initTimelineMark(&timeline, "profiler");
 
 #if defined(ENABLE_FORGE_TOUCH_INPUT)
-        for (uint32_t t = 0; t < TF_ARRAY_COUNT(gTouches); ++t)
-        {
-            gTouches[t].mId = TOUCH_ID_INVALID;
-        }
+        resetTouches();
         pCustomTouchEventFn = OnTouchEvent;
 #endif
+        initGamepadRegistry();
 
         mSettings.mShowPlatformUI = false;
 
         // Add custom binding for the input
-#define BINDING_ACTION(x)                                \
-    inputAddCustomBindings(#x "; analog; " #x "; 1.0f"); \
-    x = inputGetCustomBindingEnum(#x);
-        DECL_INPUTS(BINDING_ACTION)
+        registerInputBindings();
 
         initScreenshotCapturer(pRenderer, pGraphicsQueue, GetName());
+        initTimelineMark(&timeline, "input bindings");
+
+        waitForAllResourceLoads();
+        initTimelineMark(&timeline, "resource loads");
+
+        // Setup action mappings and callbacks, needs the device textures
+        OnDeviceSwitch(nullptr);
+        logInitTimeline(&timeline, GetName(), gInitBudgetMs);
+
         return true;
     }
 
     void Exit()
     {
+        exitInputRecorder(&gInputRecorder);
+
         exitScreenshotCapturer();
         waitQueueIdle(pGraphicsQueue);
 
+        if (gInputFrames)
+            LOGF(LogLevel::eINFO, "Input processing (%s): %.2f us per frame over %u frames", gInputPerKey ? "per key" : "snapshot",
+                 (double)gInputUSec / gInputFrames, gInputFrames);
+        LOGF(LogLevel::eINFO, "Frames rendered: %u, skipped while idle: %u", gRenderedFrames, gSkippedFrames);
+        if (gInputSampling)
+            LOGF(LogLevel::eINFO, "Input sampling: %u presses, %u within one frame, %u samples dropped", gInputPresses,
+                 gInputSubFramePresses, gInputSampleDrops);
+#if defined(ENABLE_FORGE_TOUCH_INPUT)
+        if (tfrg_atomic32_load_relaxed(&gTouchEventDrops))
+            LOGF(LogLevel::eWARNING, "Touch events dropped on a full queue: %u", tfrg_atomic32_load_relaxed(&gTouchEventDrops));
+#endif
+        if (gLatencySampleCount)
+            dumpLatencyCsv(NULL);
+
+        removeShaders();
+
         exitUserInterface();
 
         exitFontSystem();
@@ -700,16 +1556,27 @@ public:
         for (uint32_t i = 0; i < gDataBufferCount; i++)
         {
             removeResource(pInputDataUniformBuffer[i]);
+            removeResource(pHighlightBuffer[i]);
         }
 
         removeResource(pGamepad);
         removeResource(pKeyboardMouse);
+        removeResource(pGamepadIds);
+        if (pKeyboardMouseIds != pGamepadIds)
+            removeResource(pKeyboardMouseIds);
 
         removeResource(pQuadVertexBuffer);
         removeResource(pQuadIndexBuffer);
 
+        exitTraceCapture();
         exitGpuCmdRing(pRenderer, &gGraphicsCmdRing);
         exitSemaphore(pRenderer, pImageAcquiredSemaphore);
+
+        PipelineCacheSaveDesc cacheSaveDesc = {};
+        cacheSaveDesc.pFileName = gPipelineCacheName;
+        savePipelineCache(pRenderer, pPipelineCache, &cacheSaveDesc);
+        removePipelineCache(pRenderer, pPipelineCache);
+
         exitRootSignature(pRenderer);
         exitResourceLoaderInterface(pRenderer);
         exitQueue(pRenderer, pGraphicsQueue);
@@ -761,16 +1628,54 @@ public:
 
             static const char* gamepadNames[MAX_GAMEPADS] = {};
             for (uint32_t i = 0; i < TF_ARRAY_COUNT(gamepadNames); ++i)
-            {
-                gamepadNames[i] = gGamepadNames[i];
-                snprintf(gGamepadNames[i], TF_ARRAY_COUNT(gGamepadNames[i]), "Gamepad[%u]", i);
-            }
+                gamepadNames[i] = gGamepads.mPorts[i].mLabel;
             DropdownWidget gamepadDropdown = {};
             gamepadDropdown.mCount = MAX_GAMEPADS;
             gamepadDropdown.pData = (uint32_t*)&gGamepadIndex;
             gamepadDropdown.pNames = gamepadNames;
             uiAddComponentWidget(pGuiWindow, "Gamepad", &gamepadDropdown, WIDGET_TYPE_DROPDOWN);
 
+            SliderUintWidget traceFramesWidget;
+            traceFramesWidget.mMin = 1;
+            traceFramesWidget.mMax = 600;
+            traceFramesWidget.mStep = 1;
+            traceFramesWidget.pData = &gTraceFrameCount;
+            uiAddComponentWidget(pGuiWindow, "Trace Frames", &traceFramesWidget, WIDGET_TYPE_SLIDER_UINT);
+
+            ButtonWidget traceButton;
+            UIWidget*    pTraceButton = uiAddComponentWidget(pGuiWindow, "Capture Chrome Trace", &traceButton, WIDGET_TYPE_BUTTON);
+            uiSetWidgetOnEditedCallback(pTraceButton, nullptr, OnTraceCaptureRequested);
+
+            CheckboxWidget onDemandCheckbox;
+            onDemandCheckbox.pData = &gOnDemandRendering;
+            uiAddComponentWidget(pGuiWindow, "On-Demand Rendering", &onDemandCheckbox, WIDGET_TYPE_CHECKBOX);
+
+            if (gButtonIdMaskAvailable)
+            {
+                CheckboxWidget buttonIdMaskCheckbox;
+                buttonIdMaskCheckbox.pData = &gButtonIdMask;
+                uiAddComponentWidget(pGuiWindow, "Button ID Mask Highlights", &buttonIdMaskCheckbox, WIDGET_TYPE_CHECKBOX);
+            }
+
+            static float4     latencyColor = { 1.0f, 1.0f, 1.0f, 1.0f };
+            DynamicTextWidget latencyWidget;
+            latencyWidget.pText = &gLatencyText;
+            latencyWidget.pColor = &latencyColor;
+            uiAddComponentWidget(pGuiWindow, "Input Latency", &latencyWidget, WIDGET_TYPE_DYNAMIC_TEXT);
+
+            if (gInputSampling)
+            {
+                static float4     inputSamplingColor = { 1.0f, 1.0f, 1.0f, 1.0f };
+                DynamicTextWidget inputSamplingWidget;
+                inputSamplingWidget.pText = &gInputSamplingText;
+                inputSamplingWidget.pColor = &inputSamplingColor;
+                uiAddComponentWidget(pGuiWindow, "Input Sampling", &inputSamplingWidget, WIDGET_TYPE_DYNAMIC_TEXT);
+            }
+
+            ButtonWidget latencyButton;
+            UIWidget*    pLatencyButton = uiAddComponentWidget(pGuiWindow, "Dump Latency CSV", &latencyButton, WIDGET_TYPE_BUTTON);
+            uiSetWidgetOnEditedCallback(pLatencyButton, nullptr, dumpLatencyCsv);
+
             if (!addSwapChain())
                 return false;
         }
@@ -796,6 +1701,9 @@ public:
         fontLoad.mLoadType = pReloadDesc->mType;
         loadFontSystem(&fontLoad);
 
+        // New swapchain images have to be drawn at least once
+        markInputDirty();
+
         return true;
     }
 
@@ -818,41 +1726,105 @@ public:
             unloadProfilerUI();
         }
 
+        // Shaders survive reloads, addShaders() only recreates the ones whose source changed
         if (pReloadDesc->mType & RELOAD_TYPE_SHADER)
         {
             removeDescriptorSets();
-            removeShaders();
         }
     }
 
     void Update(float deltaTime)
     {
-        for (uint32_t i = 0; i < TF_ARRAY_COUNT(gGamepadNames); ++i)
+        TRACE_SCOPE("Update");
+        if (!inputRecordBeginFrame(&gInputRecorder, &deltaTime))
         {
-            snprintf(gGamepadNames[i], TF_ARRAY_COUNT(gGamepadNames[i]), "Gamepad[%u] %s", i,
-                     (inputGamepadIsActive(i) ? inputGamepadName(i) : "Not connected"));
+            // End of the replay, the benchmark run is over
+            requestShutdown();
         }
 
-        InputChecker();
+        // Gamepad names in the dropdown change on connect and disconnect
+        if (updateGamepadRegistry())
+            gRedrawFrames = gRedrawFrameCount;
 
-        if (pInputDeviceTexture != pPrevInputDeviceTexture)
+        recordInputDevice();
+        if (gInputSampling)
         {
-            DescriptorData param = {};
-            param.mIndex = SRT_RES_IDX(SrtData, Persistent, gTexture);
-            param.ppTextures = &pInputDeviceTexture;
-            updateDescriptorSet(pRenderer, 0, pDescriptorDevice, 1, &param);
-
-            pPrevInputDeviceTexture = pInputDeviceTexture;
+            sampleInput();
+            // Skipped passes leave their samples in the ring for the next rendered frame
+            if (!gOnDemandRendering || gRedrawFrames)
+                consumeInputSamples();
+        }
+        else
+        {
+            InputChecker();
         }
+        recordInputState();
+
+#if defined(ENABLE_FORGE_TOUCH_INPUT)
+        // Ended touches need one more frame to clear their text
+        if (consumeTouchEvents())
+            gRedrawFrames = gRedrawFrameCount;
+#endif
+        inputRecordEndFrame(&gInputRecorder);
 
         if (gEnableRumbleAndLights)
         {
             DoRumbleAndLightsTestSequence(deltaTime);
         }
+
+        gConstantData.buttonIdMask = gButtonIdMask && gButtonIdMaskAvailable ? 1 : 0;
+        if (memcmp(&gConstantData, &gLastConstantData, sizeof(gConstantData)) != 0)
+        {
+            gLastConstantData = gConstantData;
+            stampInputChange(getUSec(true));
+            markInputDirty();
+        }
+        if (isUiActive())
+            gRedrawFrames = gRedrawFrameCount;
+    }
+
+    // Anything the UI, the profiler or a capture would draw differently keeps the sample rendering
+    bool isUiActive()
+    {
+        bool active = gEnableRumbleAndLights || traceCaptureIsBusy() || uiIsFocused() ||
+                      (bool)pSwapChain->mEnableVsync != mSettings.mVSyncEnabled;
+
+        const float mouse[2] = { inputGetValue(0, MOUSE_X), inputGetValue(0, MOUSE_Y) };
+        if (mouse[0] != gLastMouse[0] || mouse[1] != gLastMouse[1])
+        {
+            gLastMouse[0] = mouse[0];
+            gLastMouse[1] = mouse[1];
+            active = true;
+        }
+        active |= inputGetValue(0, MOUSE_1) || inputGetValue(0, MOUSE_2) || inputGetValue(0, MOUSE_WHEEL_UP) ||
+                  inputGetValue(0, MOUSE_WHEEL_DOWN);
+
+#if defined(ENABLE_FORGE_TOUCH_INPUT)
+        active |= gTouchCount != 0;
+#endif
+        return active;
+    }
+
+    void markInputDirty()
+    {
+        gUniformDirtyMask = (1u << gDataBufferCount) - 1;
+        gRedrawFrames = gRedrawFrameCount;
     }
 
     void Draw()
     {
+        if (gOnDemandRendering && !gRedrawFrames)
+        {
+            // The last presented image stays on screen, sleep instead of spinning on Update()
+            ++gSkippedFrames;
+            threadSleep(gInputSampling ? gInputSampleSleepMs : gIdleSleepMs);
+            return;
+        }
+        if (gRedrawFrames)
+            --gRedrawFrames;
+        ++gRenderedFrames;
+
+        TRACE_SCOPE("Draw");
         if ((bool)pSwapChain->mEnableVsync != mSettings.mVSyncEnabled)
         {
             waitQueueIdle(pGraphicsQueue);
@@ -865,23 +1837,61 @@ public:
 
         // Stall if CPU is running "gDataBufferCount" frames ahead of GPU
         GpuCmdRingElement elem = getNextGpuCmdRingElement(&gGraphicsCmdRing, true, 1);
-        FenceStatus       fenceStatus;
-        getFenceStatus(pRenderer, elem.pFence, &fenceStatus);
-        if (fenceStatus == FENCE_STATUS_INCOMPLETE)
-            waitForFences(pRenderer, 1, &elem.pFence);
+        {
+            TRACE_SCOPE("Wait Frame Fence");
+            FenceStatus fenceStatus;
+            getFenceStatus(pRenderer, elem.pFence, &fenceStatus);
+            if (fenceStatus == FENCE_STATUS_INCOMPLETE)
+                waitForFences(pRenderer, 1, &elem.pFence);
+        }
+
+        // The fence of this slot is signaled now, the other frames in flight are only polled
+        const int64_t now = getUSec(true);
+        for (uint32_t i = 0; i < gDataBufferCount; ++i)
+        {
+            LatencyFrame& frame = gLatencyFrames[i];
+            if (!frame.pFence)
+                continue;
+            FenceStatus fenceStatus = FENCE_STATUS_COMPLETE;
+            if (i != gFrameIndex)
+                getFenceStatus(pRenderer, frame.pFence, &fenceStatus);
+            if (fenceStatus == FENCE_STATUS_COMPLETE)
+                completeLatencyFrame(&frame, now);
+        }
 
-        gConstantData.wndSize = { pRenderTarget->mWidth, pRenderTarget->mHeight };
+        const float2 wndSize = { pRenderTarget->mWidth, pRenderTarget->mHeight };
+        if (wndSize.x != gConstantData.wndSize.x || wndSize.y != gConstantData.wndSize.y)
+        {
+            gConstantData.wndSize = wndSize;
+            gLastConstantData.wndSize = wndSize;
+            gUniformDirtyMask = (1u << gDataBufferCount) - 1;
+        }
+
+        if (gUniformDirtyMask & (1u << gFrameIndex))
+        {
+            BufferUpdateDesc inputData = { pInputDataUniformBuffer[gFrameIndex] };
+            beginUpdateResource(&inputData);
+            memcpy(inputData.pMappedData, &gConstantData, sizeof(gConstantData));
+            endUpdateResource(&inputData);
 
-        BufferUpdateDesc inputData = { pInputDataUniformBuffer[gFrameIndex] };
-        beginUpdateResource(&inputData);
-        memcpy(inputData.pMappedData, &gConstantData, sizeof(gConstantData));
-        endUpdateResource(&inputData);
+            gHighlightCount[gFrameIndex] = buildHighlights();
+            if (gHighlightCount[gFrameIndex])
+            {
+                const uint64_t   highlightSize = gHighlightCount[gFrameIndex] * sizeof(float4);
+                BufferUpdateDesc highlightData = { pHighlightBuffer[gFrameIndex], 0, highlightSize };
+                beginUpdateResource(&highlightData);
+                memcpy(highlightData.pMappedData, gHighlights, highlightSize);
+                endUpdateResource(&highlightData);
+            }
+            gUniformDirtyMask &= ~(1u << gFrameIndex);
+        }
 
         // Reset cmd pool for this frame
         resetCmdPool(pRenderer, elem.pCmdPool);
 
         Cmd* cmd = elem.pCmds[0];
         beginCmd(cmd);
+        traceCaptureBeginFrame(cmd);
 
         cmdBeginGpuFrameProfile(cmd, gGpuProfileToken);
 
@@ -893,6 +1903,7 @@ public:
         cmdResourceBarrier(cmd, 0, NULL, 0, NULL, 1, &barrier);
 
         cmdBeginGpuTimestampQuery(cmd, gGpuProfileToken, "Basic Draw");
+        traceGpuBegin(cmd, "Basic Draw");
 
         BindRenderTargetsDesc bindRenderTargets = {};
         bindRenderTargets.mRenderTargetCount = 1;
@@ -904,14 +1915,27 @@ public:
         cmdBindPipeline(cmd, pBasicPipeline);
         cmdBindIndexBuffer(cmd, pQuadIndexBuffer, INDEX_TYPE_UINT16, 0);
 
-        cmdBindDescriptorSet(cmd, 0, pDescriptorDevice);
+        cmdBindDescriptorSet(cmd, getDeviceDescriptorIndex(), pDescriptorDevice);
         cmdBindDescriptorSet(cmd, gFrameIndex, pDescriptorInputData);
         cmdBindVertexBuffer(cmd, 1, &pQuadVertexBuffer, &stride, NULL);
         cmdDrawIndexed(cmd, 6, 0, 0);
 
+        traceGpuEnd(cmd);
         cmdEndGpuTimestampQuery(cmd, gGpuProfileToken);
 
+        if (gHighlightCount[gFrameIndex])
+        {
+            // Same descriptor sets, index and vertex buffers as the device quad
+            cmdBeginGpuTimestampQuery(cmd, gGpuProfileToken, "Button Highlights");
+            traceGpuBegin(cmd, "Button Highlights");
+            cmdBindPipeline(cmd, pHighlightPipeline);
+            cmdDrawIndexedInstanced(cmd, 6, 0, gHighlightCount[gFrameIndex], 0, 0);
+            traceGpuEnd(cmd);
+            cmdEndGpuTimestampQuery(cmd, gGpuProfileToken);
+        }
+
         cmdBeginGpuTimestampQuery(cmd, gGpuProfileToken, "Draw UI");
+        traceGpuBegin(cmd, "Draw UI");
 
         gFrameTimeDraw.mFontColor = 0xff00ffff;
         gFrameTimeDraw.mFontID = gFontID;
@@ -926,7 +1950,7 @@ public:
         txtSizePx.y = 15.0f;
         if (gChosenDeviceType == INPUT_DEVICE_TOUCH)
         {
-            for (uint32_t t = 0; t < TF_ARRAY_COUNT(gTouches); ++t)
+            for (uint32_t t = 0; t < gTouchCount; ++t)
             {
                 const char* phaseNames[] = {
                     "BEGAN",
@@ -935,10 +1959,6 @@ public:
                     "CANCELED",
                 };
                 const TouchEvent& event = gTouches[t];
-                if (TOUCH_ID_INVALID == event.mId)
-                {
-                    continue;
-                }
                 const int textSize = 256;
                 char      gestureText[textSize] = { 0 };
                 snprintf(gestureText, textSize, "TouchEvent %10d : Pos (%d : %d) Phase (%s)", event.mId, event.mPos[0], event.mPos[1],
@@ -952,12 +1972,14 @@ public:
 
         cmdDrawUserInterface(cmd);
         cmdBindRenderTargets(cmd, NULL);
+        traceGpuEnd(cmd);
         cmdEndGpuTimestampQuery(cmd, gGpuProfileToken);
 
         barrier = { pRenderTarget, RESOURCE_STATE_RENDER_TARGET, RESOURCE_STATE_PRESENT };
         cmdResourceBarrier(cmd, 0, NULL, 0, NULL, 1, &barrier);
 
         cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
+        traceCaptureEndFrame(cmd);
         endCmd(cmd);
 
         FlushResourceUpdateDesc flushUpdateDesc = {};
@@ -973,6 +1995,7 @@ public:
         submitDesc.ppSignalSemaphores = &elem.pSemaphore;
         submitDesc.ppWaitSemaphores = waitSemaphores;
         submitDesc.pSignalFence = elem.pFence;
+        traceCaptureSubmit();
         queueSubmit(pGraphicsQueue, &submitDesc);
 
         QueuePresentDesc presentDesc = {};
@@ -981,7 +2004,20 @@ public:
         presentDesc.pSwapChain = pSwapChain;
         presentDesc.ppWaitSemaphores = &elem.pSemaphore;
         presentDesc.mSubmitDone = true;
-        queuePresent(pGraphicsQueue, &presentDesc);
+        const int64_t submitUSec = getUSec(true);
+        {
+            TRACE_SCOPE("Present");
+            queuePresent(pGraphicsQueue, &presentDesc);
+        }
+
+        if (gPendingInputUSec)
+        {
+            LatencyFrame& frame = gLatencyFrames[gFrameIndex];
+            frame.pFence = elem.pFence;
+            frame.mSample = { gFrameCount, gPendingInputUSec, submitUSec, getUSec(true), 0 };
+            gPendingInputUSec = 0;
+        }
+        ++gFrameCount;
 
         flipProfiler();
 
@@ -1009,7 +2045,7 @@ public:
 
     void addDescriptorSets()
     {
-        DescriptorSetDesc desc = SRT_SET_DESC(SrtData, Persistent, 1, 0);
+        DescriptorSetDesc desc = SRT_SET_DESC(SrtData, Persistent, gDeviceDescriptorCount, 0);
         addDescriptorSet(pRenderer, &desc, &pDescriptorDevice);
 
         desc = SRT_SET_DESC(SrtData, PerFrame, gDataBufferCount, 0);
@@ -1024,13 +2060,44 @@ public:
 
     void addShaders()
     {
-        ShaderLoadDesc basicShader = {};
-        basicShader.mVert.pFileName = "basic.vert";
-        basicShader.mFrag.pFileName = "basic.frag";
-        addShader(pRenderer, &basicShader, &pBasicShader);
+        ShaderArchive archive = {};
+        openShaderArchive(GetName(), &archive);
+
+        // Only reloads compare against the loose binaries the reload server wrote, the first load trusts the archive
+        const uint64_t binaryHash = pBasicShader ? getShaderPairHash(&archive, "basic.vert", "basic.frag") : 0;
+        if (!pBasicShader || !binaryHash || binaryHash != gBasicShaderBinaryHash)
+        {
+            if (pBasicShader)
+                removeShader(pRenderer, pBasicShader);
+            pBasicShader = NULL;
+            gBasicShaderBinaryHash = addShaderPair(pRenderer, &archive, "basic.vert", "basic.frag", binaryHash, &pBasicShader);
+        }
+
+        const uint64_t highlightBinaryHash = pHighlightShader ? getShaderPairHash(&archive, "highlight.vert", "highlight.frag") : 0;
+        if (!pHighlightShader || !highlightBinaryHash || highlightBinaryHash != gHighlightShaderBinaryHash)
+        {
+            if (pHighlightShader)
+                removeShader(pRenderer, pHighlightShader);
+            pHighlightShader = NULL;
+            gHighlightShaderBinaryHash =
+                addShaderPair(pRenderer, &archive, "highlight.vert", "highlight.frag", highlightBinaryHash, &pHighlightShader);
+        }
+
+        closeShaderArchive(&archive);
     }
 
-    void removeShaders() { removeShader(pRenderer, pBasicShader); }
+    void removeShaders()
+    {
+        if (pBasicShader)
+            removeShader(pRenderer, pBasicShader);
+        pBasicShader = NULL;
+        gBasicShaderBinaryHash = 0;
+
+        if (pHighlightShader)
+            removeShader(pRenderer, pHighlightShader);
+        pHighlightShader = NULL;
+        gHighlightShaderBinaryHash = 0;
+    }
 
     void addPipelines()
     {
@@ -1057,6 +2124,7 @@ public:
         PipelineDesc desc = {};
         PIPELINE_LAYOUT_DESC(desc, SRT_LAYOUT_DESC(SrtData, Persistent), SRT_LAYOUT_DESC(SrtData, PerFrame), NULL, NULL);
         desc.mType = PIPELINE_TYPE_GRAPHICS;
+        desc.pCache = pPipelineCache;
         GraphicsPipelineDesc& pipelineSettings = desc.mGraphicsDesc;
         pipelineSettings.mPrimitiveTopo = PRIMITIVE_TOPO_TRI_LIST;
         pipelineSettings.mRenderTargetCount = 1;
@@ -1067,30 +2135,36 @@ public:
         pipelineSettings.pShaderProgram = pBasicShader;
         pipelineSettings.pVertexLayout = &vertexLayout;
         pipelineSettings.pRasterizerState = &rasterizerStateDesc;
+        int64_t start = getUSec(true);
         addPipeline(pRenderer, &desc, &pBasicPipeline);
+        LOGF(LogLevel::eINFO, "Pipeline creation (%s cache): pBasicPipeline %.3f ms", gPipelineCacheWarm ? "warm" : "cold",
+             (getUSec(true) - start) / 1000.0f);
+
+        pipelineSettings.pShaderProgram = pHighlightShader;
+        start = getUSec(true);
+        addPipeline(pRenderer, &desc, &pHighlightPipeline);
+        LOGF(LogLevel::eINFO, "Pipeline creation (%s cache): pHighlightPipeline %.3f ms", gPipelineCacheWarm ? "warm" : "cold",
+             (getUSec(true) - start) / 1000.0f);
+        gPipelineCacheWarm = true;
     }
 
-    void removePipelines() { removePipeline(pRenderer, pBasicPipeline); }
+    void removePipelines()
+    {
+        removePipeline(pRenderer, pHighlightPipeline);
+        removePipeline(pRenderer, pBasicPipeline);
+    }
 
     void prepareDescriptorSets()
     {
-        DescriptorData param = {};
-        param.mIndex = SRT_RES_IDX(SrtData, Persistent, gTexture);
-        switch (gConstantData.deviceType)
-        {
-        case INPUT_DEVICE_GAMEPAD:
-            param.ppTextures = &pGamepad;
-            updateDescriptorSet(pRenderer, 0, pDescriptorDevice, 1, &param);
-            break;
-        case INPUT_DEVICE_KBM:
-            param.ppTextures = &pKeyboardMouse;
-            updateDescriptorSet(pRenderer, 0, pDescriptorDevice, 1, &param);
-            break;
-#if defined(ENABLE_FORGE_TOUCH_INPUT)
-        case INPUT_DEVICE_TOUCH:
-            break;
-#endif
-        }
+        DescriptorData params[2] = {};
+        params[0].mIndex = SRT_RES_IDX(SrtData, Persistent, gTexture);
+        params[1].mIndex = SRT_RES_IDX(SrtData, Persistent, gButtonIds);
+        params[0].ppTextures = &pGamepad;
+        params[1].ppTextures = &pGamepadIds;
+        updateDescriptorSet(pRenderer, INPUT_DEVICE_GAMEPAD, pDescriptorDevice, 2, params);
+        params[0].ppTextures = &pKeyboardMouse;
+        params[1].ppTextures = &pKeyboardMouseIds;
+        updateDescriptorSet(pRenderer, INPUT_DEVICE_KBM, pDescriptorDevice, 2, params);
 
         for (uint32_t i = 0; i < gDataBufferCount; ++i)
         {
@@ -1098,6 +2172,11 @@ public:
             uParam.mIndex = SRT_RES_IDX(SrtData, PerFrame, gInputData);
             uParam.ppBuffers = &pInputDataUniformBuffer[i];
             updateDescriptorSet(pRenderer, i, pDescriptorInputData, 1, &uParam);
+
+            DescriptorData hParam = {};
+            hParam.mIndex = SRT_RES_IDX(SrtData, PerFrame, gHighlights);
+            hParam.ppBuffers = &pHighlightBuffer[i];
+            updateDescriptorSet(pRenderer, i, pDescriptorInputData, 1, &hParam);
         }
     }
 };
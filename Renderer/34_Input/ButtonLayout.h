@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2017-2025 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+// Button centers in device texture space: v goes from 0 to 1 over the texture height and u is scaled by the same
+// factor, so highlight circles stay round. highlight.vert.fsl maps them onto the fitted device texture.
+
+struct ButtonPos
+{
+    float x;
+    float y;
+};
+
+// Gamepad
+static constexpr ButtonPos LEFT_STICK_POS = { 0.213f, 0.540f };
+static constexpr ButtonPos RIGHT_STICK_POS = { 0.577f, 0.688f };
+static constexpr ButtonPos BUTTON_DPAD_LEFT_POS = { 0.281f, 0.688f };
+static constexpr ButtonPos BUTTON_DPAD_RIGHT_POS = { 0.379f, 0.688f };
+static constexpr ButtonPos BUTTON_DPAD_UP_POS = { 0.331f, 0.64f };
+static constexpr ButtonPos BUTTON_DPAD_DOWN_POS = { 0.331f, 0.74f };
+static constexpr ButtonPos BUTTON_SOUTH_POS = { 0.709f, 0.605f };
+static constexpr ButtonPos BUTTON_EAST_POS = { 0.775f, 0.541f };
+static constexpr ButtonPos BUTTON_WEST_POS = { 0.643f, 0.541f };
+static constexpr ButtonPos BUTTON_NORTH_POS = { 0.709f, 0.475f };
+
+static constexpr ButtonPos BUTTON_L1_POS = { 0.23f, 0.23f };
+static constexpr ButtonPos BUTTON_R1_POS = { 0.688f, 0.23f };
+static constexpr ButtonPos BUTTON_L2_POS = { 0.23f, 0.16f };
+static constexpr ButtonPos BUTTON_R2_POS = { 0.688f, 0.16f };
+static constexpr ButtonPos BUTTON_L3_POS = LEFT_STICK_POS;
+static constexpr ButtonPos BUTTON_R3_POS = RIGHT_STICK_POS;
+
+static constexpr ButtonPos BUTTON_START_POS = { 0.775f - 0.224f, 0.541f };
+static constexpr ButtonPos BUTTON_SELECT_POS = { 0.213f + 0.16f, 0.541f };
+static constexpr ButtonPos BUTTON_HOME_POS = { 0.213f + 0.248f, 0.545f };
+
+
+// Keyboard+Mouse
+static constexpr ButtonPos ESCAPE_POS = { 0.1f, 0.07f };
+static constexpr ButtonPos F1_POS = { 0.25f, 0.07f };
+static constexpr ButtonPos F2_POS = { 0.4f, 0.07f };
+static constexpr ButtonPos F3_POS = { 0.55f, 0.07f };
+static constexpr ButtonPos F4_POS = { 0.7f, 0.07f };
+static constexpr ButtonPos F5_POS = { 0.85f, 0.07f };
+static constexpr ButtonPos F6_POS = { 1.f, 0.07f };
+static constexpr ButtonPos F7_POS = { 1.15f, 0.07f };
+static constexpr ButtonPos F8_POS = { 1.3f, 0.07f };
+static constexpr ButtonPos F9_POS = { 1.45f, 0.07f };
+static constexpr ButtonPos F10_POS = { 1.6f, 0.07f };
+static constexpr ButtonPos F11_POS = { 1.75f, 0.07f };
+static constexpr ButtonPos F12_POS = { 1.9f, 0.07f };
+static constexpr ButtonPos BREAK_POS = { 2.2f, 0.07f };
+static constexpr ButtonPos INSERT_POS = { 2.35f, 0.07f };
+static constexpr ButtonPos DEL_POS = { 2.5f, 0.07f };
+static constexpr ButtonPos NUM_LOCK_POS = { 2.65f, 0.07f };
+static constexpr ButtonPos KP_MULTIPLY_POS = { 2.95f, 0.07f };
+
+static constexpr ButtonPos ACUTE_POS = { 0.1f, 0.2f };
+static constexpr ButtonPos NUM_1_POS = { ACUTE_POS.x + (0.17f * 1.f), 0.2f };
+static constexpr ButtonPos NUM_2_POS = { ACUTE_POS.x + (0.17f * 2.f), 0.2f };
+static constexpr ButtonPos NUM_3_POS = { ACUTE_POS.x + (0.17f * 3.f), 0.2f };
+static constexpr ButtonPos NUM_4_POS = { ACUTE_POS.x + (0.17f * 4.f), 0.2f };
+static constexpr ButtonPos NUM_5_POS = { ACUTE_POS.x + (0.17f * 5.f), 0.2f };
+static constexpr ButtonPos NUM_6_POS = { ACUTE_POS.x + (0.17f * 6.f), 0.2f };
+static constexpr ButtonPos NUM_7_POS = { ACUTE_POS.x + (0.17f * 7.f), 0.2f };
+static constexpr ButtonPos NUM_8_POS = { ACUTE_POS.x + (0.17f * 8.f), 0.2f };
+static constexpr ButtonPos NUM_9_POS = { ACUTE_POS.x + (0.17f * 9.f), 0.2f };
+static constexpr ButtonPos NUM_0_POS = { ACUTE_POS.x + (0.17f * 10.f), 0.2f };
+static constexpr ButtonPos MINUS_POS = { ACUTE_POS.x + (0.17f * 11.f), 0.2f };
+static constexpr ButtonPos EQUAL_POS = { ACUTE_POS.x + (0.17f * 12.f), 0.2f };
+static constexpr ButtonPos BACK_SPACE_POS = { ACUTE_POS.x + (0.17f * 13.f) + (0.17f * 0.5f), 0.2f };
+static constexpr ButtonPos KP_ADD_POS = { BACK_SPACE_POS.x + (0.17f * 2.3f), 0.2f };
+static constexpr ButtonPos KP_SUBTRACT_POS = { KP_ADD_POS.x + 0.155f, 0.2f };
+
+static constexpr ButtonPos TAB_POS = { 0.15f, 0.375f };
+static constexpr ButtonPos Q_POS = { 0.36f, 0.375f };
+static constexpr ButtonPos W_POS = { Q_POS.x + (0.168f * 1.f), 0.375f };
+static constexpr ButtonPos E_POS = { Q_POS.x + (0.168f * 2.f), 0.375f };
+static constexpr ButtonPos R_POS = { Q_POS.x + (0.168f * 3.f), 0.375f };
+static constexpr ButtonPos T_POS = { Q_POS.x + (0.168f * 4.f), 0.375f };
+static constexpr ButtonPos Y_POS = { Q_POS.x + (0.168f * 5.f), 0.375f };
+static constexpr ButtonPos U_POS = { Q_POS.x + (0.168f * 6.f), 0.375f };
+static constexpr ButtonPos I_POS = { Q_POS.x + (0.168f * 7.f), 0.375f };
+static constexpr ButtonPos O_POS = { Q_POS.x + (0.168f * 8.f), 0.375f };
+static constexpr ButtonPos P_POS = { Q_POS.x + (0.168f * 9.f), 0.375f };
+static constexpr ButtonPos BRACKET_LEFT_POS = { Q_POS.x + (0.168f * 10.f), 0.375f };
+static constexpr ButtonPos BRACKET_RIGHT_POS = { Q_POS.x + (0.168f * 11.f), 0.375f };
+static constexpr ButtonPos BACK_SLASH_POS = { Q_POS.x + (0.168f * 12.f) + 0.055f, 0.375f };
+static constexpr ButtonPos KP_7_HOME_POS = { KP_ADD_POS.x - 0.155f, 0.375f };
+static constexpr ButtonPos KP_8_UP_POS = { KP_7_HOME_POS.x + 0.155f, 0.375f };
+static constexpr ButtonPos KP_9_PAGE_UP_POS = { KP_8_UP_POS.x + 0.155f, 0.375f };
+
+static constexpr ButtonPos CAPS_LOCK_POS = { 0.168f, 0.544f };
+static constexpr ButtonPos A_POS = { 0.40f, 0.544f };
+static constexpr ButtonPos S_POS = { A_POS.x + (0.168f * 1.f), 0.544f };
+static constexpr ButtonPos D_POS = { A_POS.x + (0.168f * 2.f), 0.544f };
+static constexpr ButtonPos F_POS = { A_POS.x + (0.168f * 3.f), 0.544f };
+static constexpr ButtonPos G_POS = { A_POS.x + (0.168f * 4.f), 0.544f };
+static constexpr ButtonPos H_POS = { A_POS.x + (0.168f * 5.f), 0.544f };
+static constexpr ButtonPos J_POS = { A_POS.x + (0.168f * 6.f), 0.544f };
+static constexpr ButtonPos K_POS = { A_POS.x + (0.168f * 7.f), 0.544f };
+static constexpr ButtonPos L_POS = { A_POS.x + (0.168f * 8.f), 0.544f };
+static constexpr ButtonPos SEMICOLON_POS = { A_POS.x + (0.168f * 9.f), 0.544f };
+static constexpr ButtonPos APOSTROPHE_POS = { A_POS.x + (0.168f * 10.f), 0.544f };
+static constexpr ButtonPos ENTER_POS = { BACK_SLASH_POS.x - 0.084f, 0.544f };
+static constexpr ButtonPos KP_4_LEFT_POS = { KP_7_HOME_POS.x, 0.544f };
+static constexpr ButtonPos KP_5_BEGIN_POS = { KP_8_UP_POS.x, 0.544f };
+static constexpr ButtonPos KP_6_RIGHT_POS = { KP_9_PAGE_UP_POS.x, 0.544f };
+
+static constexpr ButtonPos SHIFT_L_POS = { 0.188f, 0.713f };
+static constexpr ButtonPos Z_POS = { 0.479f, 0.713f };
+static constexpr ButtonPos X_POS = { Z_POS.x + (0.168f * 1.f), 0.713f };
+static constexpr ButtonPos C_POS = { Z_POS.x + (0.168f * 2.f), 0.713f };
+static constexpr ButtonPos V_POS = { Z_POS.x + (0.168f * 3.f), 0.713f };
+static constexpr ButtonPos B_POS = { Z_POS.x + (0.168f * 4.f), 0.713f };
+static constexpr ButtonPos N_POS = { Z_POS.x + (0.168f * 5.f), 0.713f };
+static constexpr ButtonPos M_POS = { Z_POS.x + (0.168f * 6.f), 0.713f };
+static constexpr ButtonPos COMMA_POS = { Z_POS.x + (0.168f * 7.f), 0.713f };
+static constexpr ButtonPos PERIOD_POS = { Z_POS.x + (0.168f * 8.f), 0.713f };
+static constexpr ButtonPos FWRD_SLASH_POS = { Z_POS.x + (0.168f * 9.f), 0.713f };
+static constexpr ButtonPos SHIFT_R_POS = { ENTER_POS.x - 0.029f, 0.713f };
+static constexpr ButtonPos KP_1_END_POS = { KP_4_LEFT_POS.x, 0.713f };
+static constexpr ButtonPos KP_2_DOWN_POS = { KP_5_BEGIN_POS.x, 0.713f };
+static constexpr ButtonPos KP_3_PAGE_DOWN_POS = { KP_6_RIGHT_POS.x, 0.713f };
+
+static constexpr ButtonPos CTRL_L_POS = { ACUTE_POS.x, 0.9f };
+static constexpr ButtonPos ALT_L_POS = { NUM_3_POS.x, 0.9f };
+static constexpr ButtonPos SPACE_POS = { NUM_6_POS.x, 0.9f };
+static constexpr ButtonPos ALT_R_POS = { NUM_9_POS.x, 0.9f };
+static constexpr ButtonPos CTRL_R_POS = { MINUS_POS.x, 0.9f };
+static constexpr ButtonPos LEFT_POS = { CTRL_R_POS.x + (0.168f * 1.f), 0.9f + 0.0335f };
+static constexpr ButtonPos RIGHT_POS = { CTRL_R_POS.x + (0.168f * 3.f), 0.9f + 0.0335f };
+static constexpr ButtonPos UP_POS = { CTRL_R_POS.x + (0.168f * 2.f), 0.9f - 0.0535f };
+static constexpr ButtonPos DOWN_POS = { CTRL_R_POS.x + (0.168f * 2.f), 0.9f + 0.0335f };
+static constexpr ButtonPos KP_0_INSERT_POS = { KP_4_LEFT_POS.x, 0.9f };
+
+static constexpr ButtonPos LEFT_CLICK_POS = { 3.23f, 0.25f };
+static constexpr ButtonPos MID_CLICK_POS = { 3.36f, 0.25f };
+static constexpr ButtonPos RIGHT_CLICK_POS = { 3.49f, 0.25f };
+static constexpr ButtonPos SCROLL_UP_POS = { 3.36f, 0.21f };
+static constexpr ButtonPos SCROLL_DOWN_POS = { 3.36f, 0.29f };
@@ -26,8 +26,10 @@
 BEGIN_SRT(SrtData)
 	BEGIN_SRT_SET(Persistent)
 		DECL_TEXTURE(Persistent, Tex2D(float4), gTexture)
+		DECL_TEXTURE(Persistent, Tex2D(uint4), gButtonIds)
 	END_SRT_SET(Persistent)
 	BEGIN_SRT_SET(PerFrame)
 		DECL_CBUFFER(PerFrame, CBUFFER(InputData), gInputData)
+		DECL_BUFFER(PerFrame, Buffer(float4), gHighlights)
 	END_SRT_SET(PerFrame)
 END_SRT(SrtData)
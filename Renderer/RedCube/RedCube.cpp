@@ -1,6 +1,7 @@
 #include "../../../../Common_3/Application/Interfaces/IApp.h"
 #include "../../../../Common_3/Utilities/Interfaces/IFileSystem.h"
 #include "../../../../Common_3/Utilities/Interfaces/ILog.h"
+#include "../../../../Common_3/Utilities/Interfaces/ITime.h"
 #include "../../../../Common_3/Graphics/Interfaces/IGraphics.h"
 #include "../../../../Common_3/Resources/ResourceLoader/Interfaces/IResourceLoader.h"
 #include "../../../../Common_3/Utilities/Math/MathTypes.h"
@@ -9,6 +10,9 @@
 #include "../../../../Common_3/Graphics/FSL/defaults.h"
 #include "./Shaders/FSL/Global.srt.h"
 
+#include "../Shared/PipelineCacheName.h"
+#include "../Shared/ShaderArchive.h"
+
 // Simple vertex structure
 struct Vertex
 {
@@ -63,8 +67,69 @@ struct UniformData
     mat4 mvp;
 };
 
+struct ObjectUniformData
+{
+    mat4 mvp;
+    vec4 positionScale;
+};
+
+// Matches gRootConstants in Global.srt.h, the one push constant block of the root signature
+struct RootConstants
+{
+    mat4     mvp;
+    vec4     positionScale;
+    uint32_t objectIndex;
+};
+
 const uint32_t gDataBufferCount = 2;
 
+// Draw submission benchmark, enabled with --draw-benchmark. Renders N cubes with each submission strategy and logs
+// API draw calls/sec, cubes/sec, CPU recording time and GPU time per configuration.
+enum DrawBenchmarkMode
+{
+    DRAW_BENCHMARK_PER_DRAW_SET = 0,  // one draw per cube, rebinding a descriptor set that points at its uniforms
+    DRAW_BENCHMARK_ROOT_CONSTANTS,    // one draw per cube, position pushed as root constants
+    DRAW_BENCHMARK_INSTANCED,         // one instanced draw, position read from a structured buffer
+    DRAW_BENCHMARK_INDIRECT,          // one cmdExecuteIndirect with a draw record per cube
+    DRAW_BENCHMARK_UNIFORM_MVP,       // per cube MVP written to mapped uniforms every frame, descriptor set rebound per draw
+    DRAW_BENCHMARK_ROOT_CONSTANT_MVP, // per cube MVP pushed as root constants, no buffer or descriptor set
+    DRAW_BENCHMARK_PUSHED_INDEX,      // one draw per cube, the instanced mode's buffer bound once, the cube's index pushed
+    DRAW_BENCHMARK_MODE_COUNT,
+};
+
+static const char* gDrawBenchmarkModeNames[DRAW_BENCHMARK_MODE_COUNT] = {
+    "Per-draw descriptor set", "Root constants", "Instanced", "Execute indirect", "Uniform MVP", "Root constant MVP", "Pushed buffer index"
+};
+static const char* gDrawBenchmarkShaderNames[DRAW_BENCHMARK_MODE_COUNT] = { "cube_perdraw.vert",   "cube_rootconst.vert",
+                                                                            "cube_instanced.vert", "cube_indirect.vert",
+                                                                            "cube_uniformmvp.vert", "cube.vert",
+                                                                            "cube_pushedindex.vert" };
+// Root constant bytes per API draw. The root signature has one push constant block, so every mode that pushes uploads
+// all of gRootConstants, however little of it its shader reads. Both are logged so the push modes are compared fairly.
+const uint32_t        gRootConstantsBytes = sizeof(mat4) + sizeof(vec4) + sizeof(uint32_t); // without RootConstants' tail padding
+static const uint32_t gDrawBenchmarkPushBytes[DRAW_BENCHMARK_MODE_COUNT] = { 0, gRootConstantsBytes, 0, 0, 0, gRootConstantsBytes,
+                                                                             gRootConstantsBytes };
+static const uint32_t gDrawBenchmarkPushBytesRead[DRAW_BENCHMARK_MODE_COUNT] = { 0, sizeof(vec4), 0, 0, 0, sizeof(mat4), sizeof(uint32_t) };
+static const uint32_t gDrawBenchmarkCounts[] = { 1, 10, 100, 1000, 10000, 100000 };
+
+const uint32_t gDrawBenchmarkCountSteps = TF_ARRAY_COUNT(gDrawBenchmarkCounts);
+const uint32_t gDrawBenchmarkStepCount = DRAW_BENCHMARK_MODE_COUNT * gDrawBenchmarkCountSteps;
+const uint32_t gMaxBenchmarkObjects = 100000;
+const uint32_t gBenchmarkGridSize = 47; // 47^3 >= gMaxBenchmarkObjects
+// Uniform buffer views need 256 byte aligned offsets on every API
+const uint32_t gObjectUniformStride = 256;
+const uint32_t gDrawBenchmarkWarmupFrames = 16;
+const uint32_t gDrawBenchmarkMeasureFrames = 64;
+
+struct DrawBenchmarkResult
+{
+    int64_t  mCpuRecordUSec;
+    int64_t  mFrameUSec;
+    uint32_t mFrameSamples;
+    double   mGpuMSec;
+    uint32_t mGpuSamples;
+};
+
 Renderer* pRenderer = nullptr;
 Queue* pGraphicsQueue = nullptr;
 GpuCmdRing gGraphicsCmdRing = {};
@@ -82,6 +147,51 @@ Buffer* pUniformBuffer[gDataBufferCount] = { nullptr };
 
 DescriptorSet* pDescriptorSetUniforms = nullptr;
 
+bool                gDrawBenchmarkActive = false;
+uint32_t            gDrawBenchmarkStep = 0;
+uint32_t            gDrawBenchmarkFrame = 0;
+int64_t             gDrawBenchmarkLastFrameTime = 0;
+DrawBenchmarkResult gDrawBenchmarkResults[gDrawBenchmarkStepCount] = {};
+// Step whose GPU time was recorded into each ring slot, ~0u when the slot holds no measurement
+uint32_t            gDrawBenchmarkPendingStep[gDataBufferCount] = {};
+double              gGpuTicksPerMSec = 0.0;
+vec4*               pObjectPositions = nullptr;
+
+Shader*        pBenchmarkShaders[DRAW_BENCHMARK_MODE_COUNT] = { nullptr };
+Pipeline*      pBenchmarkPipelines[DRAW_BENCHMARK_MODE_COUNT] = { nullptr };
+Buffer*        pObjectDataBuffer = nullptr;
+Buffer*        pObjectUniformBuffer = nullptr;
+Buffer*        pIndirectBuffer = nullptr;
+DescriptorSet* pDescriptorSetObjects = nullptr;
+DescriptorSet* pDescriptorSetPerDraw = nullptr;
+QueryPool*     pTimestampQueryPool[gDataBufferCount] = { nullptr };
+float          gBenchmarkTime = 0.0f;
+
+// The cube's MVP is pushed as root constants, so drawing it needs neither a uniform buffer nor a descriptor set
+uint32_t gRootConstantsIndex = 0;
+
+// With the MVP recorded as a root constant nothing in the default frame changes until the next resize, so the whole
+// frame is recorded once per swapchain image in Load, or when the draw benchmark ends, and only resubmitted.
+// --rerecord records every frame instead.
+// There is one copy per ring slot as well, so the slot fence Draw already waits on also guards the command buffer.
+struct PrerecordedFrame
+{
+    CmdPool* pCmdPool;
+    Cmd*     pCmd;
+};
+
+const uint32_t   gMaxPrerecordedImages = 8;
+PrerecordedFrame gPrerecordedFrames[gMaxPrerecordedImages][gDataBufferCount] = {};
+bool             gPrerecordFrames = true;
+// CPU time after the frame fence wait up to the submit, per mode (0 = recorded every frame, 1 = prerecorded)
+int64_t          gDrawCpuUSec[2] = {};
+uint32_t         gDrawCpuFrames[2] = {};
+
+// Shared by every pipeline this sample creates, loaded in Init and written back to disk in Exit
+PipelineCache* pPipelineCache = nullptr;
+char           gPipelineCacheName[FS_MAX_PATH] = {};
+bool           gPipelineCacheWarm = false;
+
 uint32_t gFrameIndex = 0;
 UniformData gUniformData;
 
@@ -100,6 +210,17 @@ public:
         }
         setupGPUConfigurationPlatformParameters(pRenderer, settings.pExtendedSettings);
 
+        for (int i = 1; i < argc; ++i)
+        {
+            if (strcmp(argv[i], "--draw-benchmark") == 0)
+                gDrawBenchmarkActive = true;
+            else if (strcmp(argv[i], "--rerecord") == 0)
+                gPrerecordFrames = false;
+        }
+        // Present must not cap the frame time that is being measured
+        if (gDrawBenchmarkActive)
+            mSettings.mVSyncEnabled = false;
+
         QueueDesc queueDesc = {};
         queueDesc.mType = QUEUE_TYPE_GRAPHICS;
         initQueue(pRenderer, &queueDesc, &pGraphicsQueue);
@@ -114,6 +235,12 @@ public:
         initSemaphore(pRenderer, &pImageAcquiredSemaphore);
         initResourceLoaderInterface(pRenderer);
 
+        getPipelineCacheName(pRenderer, GetName(), gPipelineCacheName, TF_ARRAY_COUNT(gPipelineCacheName));
+        gPipelineCacheWarm = fsFileExist(RD_PIPELINE_CACHE, gPipelineCacheName);
+        PipelineCacheLoadDesc cacheDesc = {};
+        cacheDesc.pFileName = gPipelineCacheName;
+        loadPipelineCache(pRenderer, &cacheDesc, &pPipelineCache);
+
         RootSignatureDesc rootDesc = {};
         INIT_RS_DESC(rootDesc, "default.rootsig", "compute.rootsig");
         initRootSignature(pRenderer, &rootDesc, &pRootSignature);
@@ -134,16 +261,24 @@ public:
         ibDesc.ppBuffer = &pIndexBuffer;
         addResource(&ibDesc, nullptr);
 
-        BufferLoadDesc ubDesc = {};
-        ubDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        ubDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
-        ubDesc.mDesc.mFlags = BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT;
-        ubDesc.mDesc.mSize = sizeof(UniformData);
-        ubDesc.pData = nullptr;
-        for (uint32_t i = 0; i < gDataBufferCount; ++i)
+        gRootConstantsIndex = getDescriptorIndexFromName(pRootSignature, "gRootConstants");
+
+        // Only the benchmark modes still read the view projection from a per-frame uniform buffer
+        if (gDrawBenchmarkActive)
         {
-            ubDesc.ppBuffer = &pUniformBuffer[i];
-            addResource(&ubDesc, nullptr);
+            BufferLoadDesc ubDesc = {};
+            ubDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            ubDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
+            ubDesc.mDesc.mFlags = BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT;
+            ubDesc.mDesc.mSize = sizeof(UniformData);
+            ubDesc.pData = nullptr;
+            for (uint32_t i = 0; i < gDataBufferCount; ++i)
+            {
+                ubDesc.ppBuffer = &pUniformBuffer[i];
+                addResource(&ubDesc, nullptr);
+            }
+
+            addDrawBenchmarkResources();
         }
 
         addShaders();
@@ -152,6 +287,8 @@ public:
             return false;
         addPipelines();
         prepareDescriptorSets();
+        if (gDrawBenchmarkActive)
+            prepareDrawBenchmarkDescriptorSets();
 
         return true;
     }
@@ -160,12 +297,23 @@ public:
     {
         waitQueueIdle(pGraphicsQueue);
 
+        for (uint32_t i = 0; i < 2; ++i)
+        {
+            if (gDrawCpuFrames[i])
+                LOGF(LogLevel::eINFO, "Draw CPU time (%s): %.2f us average over %u frames", i ? "prerecorded" : "recorded every frame",
+                     (double)gDrawCpuUSec[i] / gDrawCpuFrames[i], gDrawCpuFrames[i]);
+        }
+
         removePipelines();
         removeDescriptorSets();
         removeShaders();
 
-        for (uint32_t i = 0; i < gDataBufferCount; ++i)
-            removeResource(pUniformBuffer[i]);
+        if (pObjectPositions)
+        {
+            removeDrawBenchmarkResources();
+            for (uint32_t i = 0; i < gDataBufferCount; ++i)
+                removeResource(pUniformBuffer[i]);
+        }
         removeResource(pVertexBuffer);
         removeResource(pIndexBuffer);
 
@@ -174,6 +322,12 @@ public:
 
         exitGpuCmdRing(pRenderer, &gGraphicsCmdRing);
         exitSemaphore(pRenderer, pImageAcquiredSemaphore);
+
+        PipelineCacheSaveDesc cacheSaveDesc = {};
+        cacheSaveDesc.pFileName = gPipelineCacheName;
+        savePipelineCache(pRenderer, pPipelineCache, &cacheSaveDesc);
+        removePipelineCache(pRenderer, pPipelineCache);
+
         exitRootSignature(pRenderer, pRootSignature);
         exitResourceLoaderInterface(pRenderer);
         exitQueue(pRenderer, pGraphicsQueue);
@@ -188,22 +342,32 @@ public:
             return false;
         addPipelines();
         prepareDescriptorSets();
+        // Draw never submits them while the draw benchmark runs
+        if (gPrerecordFrames && !gDrawBenchmarkActive)
+            addPrerecordedFrames();
         return true;
     }
 
     void Unload(ReloadDesc* reload)
     {
         waitQueueIdle(pGraphicsQueue);
+        removePrerecordedFrames();
         removePipelines();
         removeRenderTarget(pRenderer, pDepthBuffer);
         removeSwapChain(pRenderer, pSwapChain);
     }
 
-    void Update(float deltaTime)
+    mat4 getCubeMvp()
     {
         mat4 view = mat4::translation(vec3(0.0f, 0.0f, -5.0f));
         mat4 proj = mat4::perspectiveReverseZ(PI / 4.0f, (float)mSettings.mWidth / (float)mSettings.mHeight, 0.1f, 100.0f);
-        gUniformData.mvp = proj * view;
+        return proj * view;
+    }
+
+    void Update(float deltaTime)
+    {
+        gUniformData.mvp = getCubeMvp();
+        gBenchmarkTime += deltaTime;
     }
 
     void Draw()
@@ -217,38 +381,34 @@ public:
         if (fenceStatus == FENCE_STATUS_INCOMPLETE)
             waitForFences(pRenderer, 1, &elem.pFence);
 
-        BufferUpdateDesc cbv = { pUniformBuffer[gFrameIndex] };
-        beginUpdateResource(&cbv);
-        memcpy(cbv.pMappedData, &gUniformData, sizeof(gUniformData));
-        endUpdateResource(&cbv);
-
-        resetCmdPool(pRenderer, elem.pCmdPool);
-        Cmd* cmd = elem.pCmds[0];
-        beginCmd(cmd);
-
-        RenderTarget* pRenderTarget = pSwapChain->ppRenderTargets[swapchainImageIndex];
-        RenderTargetBarrier barrier = { pRenderTarget, RESOURCE_STATE_PRESENT, RESOURCE_STATE_RENDER_TARGET };
-        cmdResourceBarrier(cmd, 0, nullptr, 0, nullptr, 1, &barrier);
+        const int64_t     drawStart = getUSec(true);
+        RenderTarget*     pRenderTarget = pSwapChain->ppRenderTargets[swapchainImageIndex];
+        PrerecordedFrame* pPrerecorded =
+            swapchainImageIndex < gMaxPrerecordedImages ? &gPrerecordedFrames[swapchainImageIndex][gFrameIndex] : nullptr;
+        const bool        prerecorded = !gDrawBenchmarkActive && pPrerecorded && pPrerecorded->pCmd;
 
-        BindRenderTargetsDesc bind = {};
-        bind.mRenderTargetCount = 1;
-        bind.mRenderTargets[0] = { pRenderTarget, LOAD_ACTION_CLEAR };
-        bind.mDepthStencil = { pDepthBuffer, LOAD_ACTION_CLEAR };
-        cmdBindRenderTargets(cmd, &bind);
-        cmdSetViewport(cmd, 0.0f, 0.0f, (float)pRenderTarget->mWidth, (float)pRenderTarget->mHeight, 0.0f, 1.0f);
-        cmdSetScissor(cmd, 0, 0, pRenderTarget->mWidth, pRenderTarget->mHeight);
+        if (pObjectPositions)
+        {
+            readDrawBenchmarkGpuTime();
 
-        cmdBindPipeline(cmd, pPipeline);
-        cmdBindDescriptorSet(cmd, gFrameIndex, pDescriptorSetUniforms);
-        const uint32_t stride = sizeof(Vertex);
-        cmdBindVertexBuffer(cmd, 1, &pVertexBuffer, &stride, nullptr);
-        cmdBindIndexBuffer(cmd, pIndexBuffer, INDEX_TYPE_UINT16, 0);
-        cmdDrawIndexed(cmd, 36, 0, 0);
+            BufferUpdateDesc cbv = { pUniformBuffer[gFrameIndex] };
+            beginUpdateResource(&cbv);
+            memcpy(cbv.pMappedData, &gUniformData, sizeof(gUniformData));
+            endUpdateResource(&cbv);
+        }
 
-        cmdBindRenderTargets(cmd, nullptr);
-        barrier = { pRenderTarget, RESOURCE_STATE_RENDER_TARGET, RESOURCE_STATE_PRESENT };
-        cmdResourceBarrier(cmd, 0, nullptr, 0, nullptr, 1, &barrier);
-        endCmd(cmd);
+        Cmd* cmd = nullptr;
+        if (prerecorded)
+        {
+            // Only ever submitted on this ring slot, so its previous submit has completed with elem.pFence above
+            cmd = pPrerecorded->pCmd;
+        }
+        else
+        {
+            resetCmdPool(pRenderer, elem.pCmdPool);
+            cmd = elem.pCmds[0];
+            recordFrame(cmd, pRenderTarget, gDrawBenchmarkActive && gDrawBenchmarkStep < gDrawBenchmarkStepCount);
+        }
 
         FlushResourceUpdateDesc flushUpdateDesc = {};
         flushUpdateDesc.mNodeIndex = 0;
@@ -264,6 +424,11 @@ public:
         submitDesc.ppWaitSemaphores = waitSemaphores;
         submitDesc.pSignalFence = elem.pFence;
         queueSubmit(pGraphicsQueue, &submitDesc);
+        if (!gDrawBenchmarkActive)
+        {
+            gDrawCpuUSec[prerecorded] += getUSec(true) - drawStart;
+            ++gDrawCpuFrames[prerecorded];
+        }
 
         QueuePresentDesc presentDesc = {};
         presentDesc.mIndex = (uint8_t)swapchainImageIndex;
@@ -273,11 +438,91 @@ public:
         presentDesc.mSubmitDone = true;
         queuePresent(pGraphicsQueue, &presentDesc);
 
+        if (gDrawBenchmarkActive)
+            advanceDrawBenchmark();
+
         gFrameIndex = (gFrameIndex + 1) % gDataBufferCount;
     }
 
     const char* GetName() { return "RedCube"; }
 
+    void recordFrame(Cmd* cmd, RenderTarget* pRenderTarget, bool benchmark)
+    {
+        beginCmd(cmd);
+
+        // Query resets are not allowed inside a render pass
+        if (benchmark)
+            cmdResetQuery(cmd, pTimestampQueryPool[gFrameIndex], 0, 1);
+
+        RenderTargetBarrier barrier = { pRenderTarget, RESOURCE_STATE_PRESENT, RESOURCE_STATE_RENDER_TARGET };
+        cmdResourceBarrier(cmd, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        BindRenderTargetsDesc bind = {};
+        bind.mRenderTargetCount = 1;
+        bind.mRenderTargets[0] = { pRenderTarget, LOAD_ACTION_CLEAR };
+        bind.mDepthStencil = { pDepthBuffer, LOAD_ACTION_CLEAR };
+        cmdBindRenderTargets(cmd, &bind);
+        cmdSetViewport(cmd, 0.0f, 0.0f, (float)pRenderTarget->mWidth, (float)pRenderTarget->mHeight, 0.0f, 1.0f);
+        cmdSetScissor(cmd, 0, 0, pRenderTarget->mWidth, pRenderTarget->mHeight);
+
+        if (benchmark)
+        {
+            drawBenchmarkCubes(cmd);
+        }
+        else
+        {
+            // Recorded by value, prerecorded frames keep the matrix of the window size they were recorded for
+            RootConstants constants = {};
+            constants.mvp = getCubeMvp();
+            cmdBindPipeline(cmd, pPipeline);
+            cmdBindPushConstants(cmd, pRootSignature, gRootConstantsIndex, &constants);
+            const uint32_t stride = sizeof(Vertex);
+            cmdBindVertexBuffer(cmd, 1, &pVertexBuffer, &stride, nullptr);
+            cmdBindIndexBuffer(cmd, pIndexBuffer, INDEX_TYPE_UINT16, 0);
+            cmdDrawIndexed(cmd, 36, 0, 0);
+        }
+
+        cmdBindRenderTargets(cmd, nullptr);
+        barrier = { pRenderTarget, RESOURCE_STATE_RENDER_TARGET, RESOURCE_STATE_PRESENT };
+        cmdResourceBarrier(cmd, 0, nullptr, 0, nullptr, 1, &barrier);
+        endCmd(cmd);
+    }
+
+    void addPrerecordedFrames()
+    {
+        for (uint32_t i = 0; i < pSwapChain->mImageCount && i < gMaxPrerecordedImages; ++i)
+        {
+            for (uint32_t slot = 0; slot < gDataBufferCount; ++slot)
+            {
+                PrerecordedFrame& frame = gPrerecordedFrames[i][slot];
+                CmdPoolDesc       cmdPoolDesc = {};
+                cmdPoolDesc.pQueue = pGraphicsQueue;
+                initCmdPool(pRenderer, &cmdPoolDesc, &frame.pCmdPool);
+                CmdDesc cmdDesc = {};
+                cmdDesc.pPool = frame.pCmdPool;
+                initCmd(pRenderer, &cmdDesc, &frame.pCmd);
+                recordFrame(frame.pCmd, pSwapChain->ppRenderTargets[i], false);
+            }
+        }
+    }
+
+    void removePrerecordedFrames()
+    {
+        for (uint32_t i = 0; i < gMaxPrerecordedImages; ++i)
+        {
+            for (uint32_t slot = 0; slot < gDataBufferCount; ++slot)
+            {
+                PrerecordedFrame& frame = gPrerecordedFrames[i][slot];
+                if (frame.pCmd)
+                {
+                    exitCmd(pRenderer, frame.pCmd);
+                    exitCmdPool(pRenderer, frame.pCmdPool);
+                }
+                frame = {};
+            }
+        }
+    }
+
     bool addSwapChain()
     {
         SwapChainDesc swapChainDesc = {};
@@ -313,26 +558,47 @@ public:
 
     void addDescriptorSets()
     {
+        if (!gDrawBenchmarkActive)
+            return;
+
         DescriptorSetDesc desc = SRT_SET_DESC(SrtData, PerFrame, gDataBufferCount, 0);
         addDescriptorSet(pRenderer, &desc, &pDescriptorSetUniforms);
+        desc = SRT_SET_DESC(SrtData, Persistent, 1, 0);
+        addDescriptorSet(pRenderer, &desc, &pDescriptorSetObjects);
+        desc = SRT_SET_DESC(SrtData, PerDraw, gDataBufferCount * gMaxBenchmarkObjects, 0);
+        addDescriptorSet(pRenderer, &desc, &pDescriptorSetPerDraw);
     }
 
     void removeDescriptorSets()
     {
-        removeDescriptorSet(pRenderer, pDescriptorSetUniforms);
+        if (pDescriptorSetUniforms)
+        {
+            removeDescriptorSet(pRenderer, pDescriptorSetUniforms);
+            removeDescriptorSet(pRenderer, pDescriptorSetObjects);
+            removeDescriptorSet(pRenderer, pDescriptorSetPerDraw);
+        }
     }
 
     void addShaders()
     {
-        ShaderLoadDesc shaderDesc = {};
-        shaderDesc.mVert.pFileName = "cube.vert";
-        shaderDesc.mFrag.pFileName = "cube.frag";
-        addShader(pRenderer, &shaderDesc, &pShader);
+        ShaderArchive archive = {};
+        openShaderArchive(GetName(), &archive);
+        // Falls back to the individual binaries by name when there is no archive
+        addShaderPair(pRenderer, &archive, "cube.vert", "cube.frag", 0, &pShader);
+        for (uint32_t i = 0; gDrawBenchmarkActive && i < DRAW_BENCHMARK_MODE_COUNT; ++i)
+            addShaderPair(pRenderer, &archive, gDrawBenchmarkShaderNames[i], "cube.frag", 0, &pBenchmarkShaders[i]);
+        closeShaderArchive(&archive);
     }
 
     void removeShaders()
     {
         removeShader(pRenderer, pShader);
+        for (uint32_t i = 0; i < DRAW_BENCHMARK_MODE_COUNT; ++i)
+        {
+            if (pBenchmarkShaders[i])
+                removeShader(pRenderer, pBenchmarkShaders[i]);
+            pBenchmarkShaders[i] = nullptr;
+        }
     }
 
     void addPipelines()
@@ -363,6 +629,7 @@ public:
         PipelineDesc desc = {};
         PIPELINE_LAYOUT_DESC(desc, SRT_LAYOUT_DESC(SrtData, PerFrame), NULL, NULL, NULL);
         desc.mType = PIPELINE_TYPE_GRAPHICS;
+        desc.pCache = pPipelineCache;
         GraphicsPipelineDesc& pipelineSettings = desc.mGraphicsDesc;
         pipelineSettings.mPrimitiveTopo = PRIMITIVE_TOPO_TRI_LIST;
         pipelineSettings.mRenderTargetCount = 1;
@@ -374,17 +641,51 @@ public:
         pipelineSettings.pShaderProgram = pShader;
         pipelineSettings.pVertexLayout = &vertexLayout;
         pipelineSettings.pRasterizerState = &rasterizerStateDesc;
+        int64_t start = getUSec(true);
         addPipeline(pRenderer, &desc, &pPipeline);
+        LOGF(LogLevel::eINFO, "Pipeline creation (%s cache): pPipeline %.3f ms", gPipelineCacheWarm ? "warm" : "cold",
+             (getUSec(true) - start) / 1000.0f);
+        gPipelineCacheWarm = true;
+
+        if (!gDrawBenchmarkActive)
+            return;
+
+        // Execute indirect reads the cube position from a per-instance stream, the other modes from descriptors
+        VertexLayout instanceLayout = vertexLayout;
+        instanceLayout.mBindingCount = 2;
+        instanceLayout.mAttribCount = 3;
+        instanceLayout.mBindings[1].mStride = sizeof(vec4);
+        instanceLayout.mBindings[1].mRate = VERTEX_BINDING_RATE_INSTANCE;
+        instanceLayout.mAttribs[2].mSemantic = SEMANTIC_TEXCOORD0;
+        instanceLayout.mAttribs[2].mFormat = TinyImageFormat_R32G32B32A32_SFLOAT;
+        instanceLayout.mAttribs[2].mBinding = 1;
+        instanceLayout.mAttribs[2].mLocation = 2;
+        instanceLayout.mAttribs[2].mOffset = 0;
+
+        PIPELINE_LAYOUT_DESC(desc, SRT_LAYOUT_DESC(SrtData, Persistent), SRT_LAYOUT_DESC(SrtData, PerFrame), NULL,
+                             SRT_LAYOUT_DESC(SrtData, PerDraw));
+        for (uint32_t i = 0; i < DRAW_BENCHMARK_MODE_COUNT; ++i)
+        {
+            pipelineSettings.pShaderProgram = pBenchmarkShaders[i];
+            pipelineSettings.pVertexLayout = i == DRAW_BENCHMARK_INDIRECT ? &instanceLayout : &vertexLayout;
+            addPipeline(pRenderer, &desc, &pBenchmarkPipelines[i]);
+        }
     }
 
     void removePipelines()
     {
         removePipeline(pRenderer, pPipeline);
+        for (uint32_t i = 0; i < DRAW_BENCHMARK_MODE_COUNT; ++i)
+        {
+            if (pBenchmarkPipelines[i])
+                removePipeline(pRenderer, pBenchmarkPipelines[i]);
+            pBenchmarkPipelines[i] = nullptr;
+        }
     }
 
     void prepareDescriptorSets()
     {
-        for (uint32_t i = 0; i < gDataBufferCount; ++i)
+        for (uint32_t i = 0; pDescriptorSetUniforms && i < gDataBufferCount; ++i)
         {
             DescriptorData params = {};
             params.mIndex = SRT_RES_IDX(SrtData, PerFrame, gUniformBlock);
@@ -392,6 +693,307 @@ public:
             updateDescriptorSet(pRenderer, i, pDescriptorSetUniforms, 1, &params);
         }
     }
+
+    // Benchmark sets only reference buffers created in Init, so they are written once instead of on every Load
+    void prepareDrawBenchmarkDescriptorSets()
+    {
+        DescriptorData params = {};
+        params.mIndex = SRT_RES_IDX(SrtData, Persistent, gObjectData);
+        params.ppBuffers = &pObjectDataBuffer;
+        updateDescriptorSet(pRenderer, 0, pDescriptorSetObjects, 1, &params);
+
+        // One set per cube and ring slot, each viewing its own 256 byte slice of the object uniform buffer
+        DescriptorDataRange range = {};
+        range.mSize = sizeof(ObjectUniformData);
+        params = {};
+        params.mIndex = SRT_RES_IDX(SrtData, PerDraw, gObjectBlock);
+        params.ppBuffers = &pObjectUniformBuffer;
+        params.pRanges = &range;
+        for (uint32_t i = 0; i < gDataBufferCount * gMaxBenchmarkObjects; ++i)
+        {
+            range.mOffset = i * gObjectUniformStride;
+            updateDescriptorSet(pRenderer, i, pDescriptorSetPerDraw, 1, &params);
+        }
+    }
+
+    void addDrawBenchmarkResources()
+    {
+        // Cubes fill a fixed grid in index order, so every count draws a prefix of the same data
+        pObjectPositions = (vec4*)tf_calloc(gMaxBenchmarkObjects, sizeof(vec4));
+        const float extent = 3.0f;
+        const float cell = extent / gBenchmarkGridSize;
+        for (uint32_t i = 0; i < gMaxBenchmarkObjects; ++i)
+        {
+            const uint32_t x = i % gBenchmarkGridSize;
+            const uint32_t y = (i / gBenchmarkGridSize) % gBenchmarkGridSize;
+            const uint32_t z = i / (gBenchmarkGridSize * gBenchmarkGridSize);
+            pObjectPositions[i] = vec4((x + 0.5f) * cell - extent * 0.5f, (y + 0.5f) * cell - extent * 0.5f,
+                                       (z + 0.5f) * cell - extent * 0.5f, cell * 0.3f);
+        }
+
+        BufferLoadDesc objectDesc = {};
+        objectDesc.mDesc.mDescriptors = (DescriptorType)(DESCRIPTOR_TYPE_BUFFER | DESCRIPTOR_TYPE_VERTEX_BUFFER);
+        objectDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_GPU_ONLY;
+        objectDesc.mDesc.mFormat = TinyImageFormat_R32G32B32A32_SFLOAT;
+        objectDesc.mDesc.mElementCount = gMaxBenchmarkObjects;
+        objectDesc.mDesc.mStructStride = sizeof(vec4);
+        objectDesc.mDesc.mSize = gMaxBenchmarkObjects * sizeof(vec4);
+        objectDesc.pData = pObjectPositions;
+        objectDesc.ppBuffer = &pObjectDataBuffer;
+        addResource(&objectDesc, nullptr);
+
+        // One slice per cube and ring slot: positions are static, the MVP is rewritten every frame by the uniform MVP mode
+        BufferLoadDesc uniformDesc = {};
+        uniformDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        uniformDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
+        uniformDesc.mDesc.mFlags = BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT;
+        uniformDesc.mDesc.mSize = (uint64_t)gDataBufferCount * gMaxBenchmarkObjects * gObjectUniformStride;
+        uniformDesc.pData = nullptr;
+        uniformDesc.ppBuffer = &pObjectUniformBuffer;
+        addResource(&uniformDesc, nullptr);
+
+        IndirectDrawIndexArguments* pArgs =
+            (IndirectDrawIndexArguments*)tf_calloc(gMaxBenchmarkObjects, sizeof(IndirectDrawIndexArguments));
+        for (uint32_t i = 0; i < gMaxBenchmarkObjects; ++i)
+        {
+            pArgs[i].mIndexCount = TF_ARRAY_COUNT(gCubeIndices);
+            pArgs[i].mInstanceCount = 1;
+            pArgs[i].mStartInstance = i;
+        }
+        BufferLoadDesc indirectDesc = {};
+        indirectDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_INDIRECT_BUFFER;
+        indirectDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_GPU_ONLY;
+        indirectDesc.mDesc.mSize = gMaxBenchmarkObjects * sizeof(IndirectDrawIndexArguments);
+        indirectDesc.pData = pArgs;
+        indirectDesc.ppBuffer = &pIndirectBuffer;
+        addResource(&indirectDesc, nullptr);
+
+        QueryPoolDesc poolDesc = {};
+        poolDesc.mQueryCount = 1;
+        poolDesc.mType = QUERY_TYPE_TIMESTAMP;
+        for (uint32_t i = 0; i < gDataBufferCount; ++i)
+        {
+            initQueryPool(pRenderer, &poolDesc, &pTimestampQueryPool[i]);
+            gDrawBenchmarkPendingStep[i] = ~0u;
+        }
+        double ticksPerSecond = 0.0;
+        getTimestampFrequency(pGraphicsQueue, &ticksPerSecond);
+        gGpuTicksPerMSec = ticksPerSecond / 1000.0;
+
+        // The staging copies have to finish before the CPU side arrays go away
+        waitForAllResourceLoads();
+        tf_free(pArgs);
+
+        uint8_t* pObjectUniforms = (uint8_t*)pObjectUniformBuffer->pCpuMappedAddress;
+        for (uint32_t i = 0; i < gDataBufferCount * gMaxBenchmarkObjects; ++i)
+        {
+            ObjectUniformData* pData = (ObjectUniformData*)(pObjectUniforms + (uint64_t)i * gObjectUniformStride);
+            pData->positionScale = pObjectPositions[i % gMaxBenchmarkObjects];
+        }
+    }
+
+    void removeDrawBenchmarkResources()
+    {
+        for (uint32_t i = 0; i < gDataBufferCount; ++i)
+            exitQueryPool(pRenderer, pTimestampQueryPool[i]);
+        removeResource(pIndirectBuffer);
+        removeResource(pObjectUniformBuffer);
+        removeResource(pObjectDataBuffer);
+        tf_free(pObjectPositions);
+        pObjectPositions = nullptr;
+    }
+
+    void drawBenchmarkCubes(Cmd* cmd)
+    {
+        const uint32_t mode = gDrawBenchmarkStep / gDrawBenchmarkCountSteps;
+        const uint32_t count = gDrawBenchmarkCounts[gDrawBenchmarkStep % gDrawBenchmarkCountSteps];
+        const bool     measure = gDrawBenchmarkFrame >= gDrawBenchmarkWarmupFrames;
+        const uint32_t indexCount = TF_ARRAY_COUNT(gCubeIndices);
+
+        QueryPool* pPool = pTimestampQueryPool[gFrameIndex];
+        QueryDesc  queryDesc = { 0 };
+        if (measure)
+            cmdBeginQuery(cmd, pPool, &queryDesc);
+
+        const int64_t start = getUSec(true);
+        cmdBindPipeline(cmd, pBenchmarkPipelines[mode]);
+        if (mode != DRAW_BENCHMARK_ROOT_CONSTANT_MVP)
+            cmdBindDescriptorSet(cmd, gFrameIndex, pDescriptorSetUniforms);
+        cmdBindIndexBuffer(cmd, pIndexBuffer, INDEX_TYPE_UINT16, 0);
+        const uint32_t stride = sizeof(Vertex);
+        RootConstants  constants = {};
+        switch (mode)
+        {
+        case DRAW_BENCHMARK_PER_DRAW_SET:
+            cmdBindVertexBuffer(cmd, 1, &pVertexBuffer, &stride, nullptr);
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                cmdBindDescriptorSet(cmd, gFrameIndex * gMaxBenchmarkObjects + i, pDescriptorSetPerDraw);
+                cmdDrawIndexed(cmd, indexCount, 0, 0);
+            }
+            break;
+        case DRAW_BENCHMARK_ROOT_CONSTANTS:
+            cmdBindVertexBuffer(cmd, 1, &pVertexBuffer, &stride, nullptr);
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                constants.positionScale = pObjectPositions[i];
+                cmdBindPushConstants(cmd, pRootSignature, gRootConstantsIndex, &constants);
+                cmdDrawIndexed(cmd, indexCount, 0, 0);
+            }
+            break;
+        case DRAW_BENCHMARK_INSTANCED:
+            cmdBindVertexBuffer(cmd, 1, &pVertexBuffer, &stride, nullptr);
+            cmdBindDescriptorSet(cmd, 0, pDescriptorSetObjects);
+            cmdDrawIndexedInstanced(cmd, indexCount, 0, count, 0, 0);
+            break;
+        case DRAW_BENCHMARK_INDIRECT:
+        {
+            Buffer*        pBuffers[] = { pVertexBuffer, pObjectDataBuffer };
+            const uint32_t strides[] = { sizeof(Vertex), sizeof(vec4) };
+            cmdBindVertexBuffer(cmd, 2, pBuffers, strides, nullptr);
+            cmdExecuteIndirect(cmd, INDIRECT_DRAW_INDEX, count, pIndirectBuffer, 0, nullptr, 0);
+            break;
+        }
+        case DRAW_BENCHMARK_UNIFORM_MVP:
+        {
+            // What the single cube used to do, scaled up: map, copy and bind a descriptor set for every matrix
+            uint8_t* pSlices =
+                (uint8_t*)pObjectUniformBuffer->pCpuMappedAddress + (uint64_t)gFrameIndex * gMaxBenchmarkObjects * gObjectUniformStride;
+            cmdBindVertexBuffer(cmd, 1, &pVertexBuffer, &stride, nullptr);
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                const mat4 mvp = getBenchmarkCubeMvp(i);
+                memcpy(pSlices + (uint64_t)i * gObjectUniformStride, &mvp, sizeof(mvp));
+                cmdBindDescriptorSet(cmd, gFrameIndex * gMaxBenchmarkObjects + i, pDescriptorSetPerDraw);
+                cmdDrawIndexed(cmd, indexCount, 0, 0);
+            }
+            break;
+        }
+        case DRAW_BENCHMARK_ROOT_CONSTANT_MVP:
+            cmdBindVertexBuffer(cmd, 1, &pVertexBuffer, &stride, nullptr);
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                constants.mvp = getBenchmarkCubeMvp(i);
+                cmdBindPushConstants(cmd, pRootSignature, gRootConstantsIndex, &constants);
+                cmdDrawIndexed(cmd, indexCount, 0, 0);
+            }
+            break;
+        case DRAW_BENCHMARK_PUSHED_INDEX:
+            // Same draws as the per-draw descriptor set mode, but all cubes live in one buffer that is bound once
+            cmdBindVertexBuffer(cmd, 1, &pVertexBuffer, &stride, nullptr);
+            cmdBindDescriptorSet(cmd, 0, pDescriptorSetObjects);
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                constants.objectIndex = i;
+                cmdBindPushConstants(cmd, pRootSignature, gRootConstantsIndex, &constants);
+                cmdDrawIndexed(cmd, indexCount, 0, 0);
+            }
+            break;
+        default:
+            break;
+        }
+        const int64_t recordTime = getUSec(true) - start;
+
+        if (measure)
+        {
+            cmdEndQuery(cmd, pPool, &queryDesc);
+            cmdResolveQuery(cmd, pPool, 0, 1);
+            gDrawBenchmarkResults[gDrawBenchmarkStep].mCpuRecordUSec += recordTime;
+            gDrawBenchmarkPendingStep[gFrameIndex] = gDrawBenchmarkStep;
+        }
+    }
+
+    // Every cube gets its own matrix, spinning at a phase derived from its index
+    mat4 getBenchmarkCubeMvp(uint32_t index)
+    {
+        const vec4& positionScale = pObjectPositions[index];
+        return gUniformData.mvp * mat4::translation(positionScale.getXYZ()) * mat4::rotationY(gBenchmarkTime + index * 0.1f) *
+               mat4::scale(vec3(positionScale.getW()));
+    }
+
+    // Called after the fence wait, the slot's timestamps belong to the frame submitted gDataBufferCount frames ago
+    void readDrawBenchmarkGpuTime()
+    {
+        const uint32_t step = gDrawBenchmarkPendingStep[gFrameIndex];
+        if (step == ~0u)
+            return;
+        gDrawBenchmarkPendingStep[gFrameIndex] = ~0u;
+
+        QueryData data = {};
+        getQueryData(pRenderer, pTimestampQueryPool[gFrameIndex], 0, &data);
+        if (!data.mValid)
+            return;
+        gDrawBenchmarkResults[step].mGpuMSec += (data.mEndTimestamp - data.mBeginTimestamp) / gGpuTicksPerMSec;
+        ++gDrawBenchmarkResults[step].mGpuSamples;
+    }
+
+    void advanceDrawBenchmark()
+    {
+        const int64_t now = getUSec(true);
+        if (gDrawBenchmarkStep < gDrawBenchmarkStepCount)
+        {
+            // Frame time is measured present to present, so it covers the whole CPU frame and any GPU bound wait
+            if (gDrawBenchmarkFrame > gDrawBenchmarkWarmupFrames)
+            {
+                gDrawBenchmarkResults[gDrawBenchmarkStep].mFrameUSec += now - gDrawBenchmarkLastFrameTime;
+                ++gDrawBenchmarkResults[gDrawBenchmarkStep].mFrameSamples;
+            }
+            if (++gDrawBenchmarkFrame == gDrawBenchmarkWarmupFrames + gDrawBenchmarkMeasureFrames)
+            {
+                gDrawBenchmarkFrame = 0;
+                ++gDrawBenchmarkStep;
+            }
+        }
+        // The last GPU timings arrive gDataBufferCount frames after the final step
+        else if (++gDrawBenchmarkFrame > gDataBufferCount)
+        {
+            logDrawBenchmark();
+            gDrawBenchmarkActive = false;
+            if (gPrerecordFrames)
+                addPrerecordedFrames();
+        }
+        gDrawBenchmarkLastFrameTime = now;
+    }
+
+    void logDrawBenchmark()
+    {
+        FileStream stream = {};
+        const bool csv = fsOpenStreamFromPath(RD_LOG, "RedCube_draw_benchmark.csv", FM_WRITE, &stream);
+        if (csv)
+            fsPrintToStream(&stream, "mode,cubes,api_draws,push_bytes,push_bytes_read,draws_per_sec,cubes_per_sec,cpu_record_ms,gpu_ms,"
+                                     "frame_ms\n");
+
+        LOGF(LogLevel::eINFO, "Draw benchmark (%u measured frames per configuration):", gDrawBenchmarkMeasureFrames);
+        LOGF(LogLevel::eINFO, "%-24s %8s %10s %8s %8s %14s %14s %12s %10s %10s", "Mode", "Cubes", "API draws", "Push B", "Read B",
+             "Draws/s", "Cubes/s", "CPU rec ms", "GPU ms", "Frame ms");
+        for (uint32_t step = 0; step < gDrawBenchmarkStepCount; ++step)
+        {
+            const DrawBenchmarkResult& result = gDrawBenchmarkResults[step];
+            const uint32_t             mode = step / gDrawBenchmarkCountSteps;
+            const uint32_t             count = gDrawBenchmarkCounts[step % gDrawBenchmarkCountSteps];
+            const bool                 singleDraw = mode == DRAW_BENCHMARK_INSTANCED || mode == DRAW_BENCHMARK_INDIRECT;
+            const uint32_t             apiDraws = singleDraw ? 1 : count;
+            const double               cpuMs = result.mCpuRecordUSec / 1000.0 / gDrawBenchmarkMeasureFrames;
+            const double               gpuMs = result.mGpuSamples ? result.mGpuMSec / result.mGpuSamples : 0.0;
+            const double               frameMs = result.mFrameSamples ? result.mFrameUSec / 1000.0 / result.mFrameSamples : 0.0;
+            // Instanced and indirect draw every cube with one API call, so draw calls and cubes are reported apart
+            const double               drawsPerSec = frameMs > 0.0 ? apiDraws * 1000.0 / frameMs : 0.0;
+            const double               cubesPerSec = frameMs > 0.0 ? count * 1000.0 / frameMs : 0.0;
+            const uint32_t             pushBytes = gDrawBenchmarkPushBytes[mode];
+            const uint32_t             pushBytesRead = gDrawBenchmarkPushBytesRead[mode];
+            LOGF(LogLevel::eINFO, "%-24s %8u %10u %8u %8u %14.0f %14.0f %12.3f %10.3f %10.3f", gDrawBenchmarkModeNames[mode], count,
+                 apiDraws, pushBytes, pushBytesRead, drawsPerSec, cubesPerSec, cpuMs, gpuMs, frameMs);
+            if (csv)
+                fsPrintToStream(&stream, "%s,%u,%u,%u,%u,%.0f,%.0f,%.4f,%.4f,%.4f\n", gDrawBenchmarkModeNames[mode], count, apiDraws,
+                                pushBytes, pushBytesRead, drawsPerSec, cubesPerSec, cpuMs, gpuMs, frameMs);
+        }
+
+        if (csv)
+        {
+            fsCloseStream(&stream);
+            LOGF(LogLevel::eINFO, "Draw benchmark results written to RedCube_draw_benchmark.csv");
+        }
+    }
 };
 
 DEFINE_APPLICATION_MAIN(RedCube)
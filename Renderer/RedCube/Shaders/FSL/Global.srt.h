@@ -1,5 +1,20 @@
 BEGIN_SRT(SrtData)
+    BEGIN_SRT_SET(Persistent)
+        DECL_BUFFER(Persistent, Buffer(float4), gObjectData)
+    END_SRT_SET(Persistent)
     BEGIN_SRT_SET(PerFrame)
         DECL_CBUFFER(PerFrame, CBUFFER(UniformData), gUniformBlock)
     END_SRT_SET(PerFrame)
+    BEGIN_SRT_SET(PerDraw)
+        DECL_CBUFFER(PerDraw, CBUFFER(ObjectUniformData), gObjectBlock)
+    END_SRT_SET(PerDraw)
 END_SRT(SrtData)
+
+// Root constants live in the root signature itself, drawing with them needs no buffer or descriptor set.
+// A root signature has a single push constant block, every draw mode pushes it whole and reads its own member.
+PUSH_CONSTANT(gRootConstants, b0)
+{
+    DATA(float4x4, mvp, None);
+    DATA(float4, positionScale, None);
+    DATA(uint, objectIndex, None);
+};
@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2017-2025 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+// Redundant state filter for command recording.
+// The cmdState* wrappers forward to the cmdBind*/cmdSet* calls of IGraphics and drop the ones that would bind what
+// is already bound: the pipeline, one descriptor set per update frequency, vertex and index buffers, viewport and
+// scissor. Every issued and skipped call is counted together with the draws, cmdStateEndFrame() publishes the
+// counts of a frame for the profiler overlay.
+//
+// The cache only knows what went through it. cmdStateBindRenderTargets() invalidates it since Metal starts every
+// render pass with a fresh encoder, anything else that binds state directly on the Cmd (UI, profiler text) needs a
+// cmdStateInvalidate() before the cache is used again. Descriptor sets stay cached across pipeline changes, so all
+// pipelines recorded through one cache must share a root signature, which holds for the SRT samples.
+
+#include "../../../../Common_3/Graphics/Interfaces/IGraphics.h"
+
+#define CMD_STATE_MAX_VERTEX_BUFFERS 4
+
+enum CmdStateSetSlot
+{
+    CMD_STATE_SET_PERSISTENT,
+    CMD_STATE_SET_PER_FRAME,
+    CMD_STATE_SET_PER_BATCH,
+    CMD_STATE_SET_PER_DRAW,
+    CMD_STATE_SET_SLOT_COUNT
+};
+
+enum CmdStateBind
+{
+    CMD_STATE_BIND_PIPELINE,
+    CMD_STATE_BIND_DESCRIPTOR_SET,
+    CMD_STATE_BIND_VERTEX_BUFFER,
+    CMD_STATE_BIND_INDEX_BUFFER,
+    CMD_STATE_BIND_VIEWPORT,
+    CMD_STATE_BIND_SCISSOR,
+    CMD_STATE_BIND_COUNT
+};
+
+static const char* gCmdStateBindNames[CMD_STATE_BIND_COUNT] = { "pipeline", "sets", "vb", "ib", "viewport", "scissor" };
+
+struct CmdStateCounters
+{
+    uint32_t mIssued[CMD_STATE_BIND_COUNT];
+    uint32_t mSkipped[CMD_STATE_BIND_COUNT];
+    uint32_t mDraws;
+};
+
+struct CmdStateCache
+{
+    Cmd*              pCmd;
+    CmdStateCounters* pCounters; // NULL for command buffers that are not recorded per frame
+
+    Pipeline*      pPipeline;
+    DescriptorSet* pSets[CMD_STATE_SET_SLOT_COUNT];
+    uint32_t       mSetIndex[CMD_STATE_SET_SLOT_COUNT];
+
+    uint32_t mVertexBufferCount;
+    Buffer*  pVertexBuffers[CMD_STATE_MAX_VERTEX_BUFFERS];
+    uint32_t mVertexStrides[CMD_STATE_MAX_VERTEX_BUFFERS];
+    uint64_t mVertexOffsets[CMD_STATE_MAX_VERTEX_BUFFERS];
+
+    Buffer*  pIndexBuffer;
+    uint32_t mIndexType;
+    uint64_t mIndexOffset;
+
+    bool     mViewportValid;
+    float    mViewport[6];
+    bool     mScissorValid;
+    uint32_t mScissor[4];
+};
+
+static inline void cmdStateInvalidate(CmdStateCache* pCache)
+{
+    Cmd*              cmd = pCache->pCmd;
+    CmdStateCounters* pCounters = pCache->pCounters;
+    *pCache = {};
+    pCache->pCmd = cmd;
+    pCache->pCounters = pCounters;
+}
+
+static inline void cmdStateBegin(CmdStateCache* pCache, Cmd* cmd, CmdStateCounters* pCounters)
+{
+    *pCache = {};
+    pCache->pCmd = cmd;
+    pCache->pCounters = pCounters;
+}
+
+// Returns true if the call has to be issued
+static inline bool cmdStateCount(CmdStateCache* pCache, CmdStateBind bind, bool redundant)
+{
+    if (pCache->pCounters)
+    {
+        if (redundant)
+            ++pCache->pCounters->mSkipped[bind];
+        else
+            ++pCache->pCounters->mIssued[bind];
+    }
+    return !redundant;
+}
+
+static inline void cmdStateBindRenderTargets(CmdStateCache* pCache, BindRenderTargetsDesc* pDesc)
+{
+    cmdBindRenderTargets(pCache->pCmd, pDesc);
+    cmdStateInvalidate(pCache);
+}
+
+static inline void cmdStateBindPipeline(CmdStateCache* pCache, Pipeline* pPipeline)
+{
+    if (cmdStateCount(pCache, CMD_STATE_BIND_PIPELINE, pCache->pPipeline == pPipeline))
+    {
+        cmdBindPipeline(pCache->pCmd, pPipeline);
+        pCache->pPipeline = pPipeline;
+    }
+}
+
+static inline void cmdStateBindDescriptorSet(CmdStateCache* pCache, CmdStateSetSlot slot, uint32_t index, DescriptorSet* pSet)
+{
+    ASSERT(slot < CMD_STATE_SET_SLOT_COUNT);
+    const bool redundant = pCache->pSets[slot] == pSet && pCache->mSetIndex[slot] == index;
+    if (cmdStateCount(pCache, CMD_STATE_BIND_DESCRIPTOR_SET, redundant))
+    {
+        cmdBindDescriptorSet(pCache->pCmd, index, pSet);
+        pCache->pSets[slot] = pSet;
+        pCache->mSetIndex[slot] = index;
+    }
+}
+
+static inline void cmdStateBindVertexBuffer(CmdStateCache* pCache, uint32_t bufferCount, Buffer** ppBuffers, const uint32_t* pStrides,
+                                            const uint64_t* pOffsets)
+{
+    ASSERT(bufferCount <= CMD_STATE_MAX_VERTEX_BUFFERS);
+    bool redundant = pCache->mVertexBufferCount == bufferCount;
+    for (uint32_t i = 0; redundant && i < bufferCount; ++i)
+    {
+        redundant = pCache->pVertexBuffers[i] == ppBuffers[i] && pCache->mVertexStrides[i] == pStrides[i] &&
+                    pCache->mVertexOffsets[i] == (pOffsets ? pOffsets[i] : 0);
+    }
+    if (cmdStateCount(pCache, CMD_STATE_BIND_VERTEX_BUFFER, redundant))
+    {
+        cmdBindVertexBuffer(pCache->pCmd, bufferCount, ppBuffers, pStrides, pOffsets);
+        pCache->mVertexBufferCount = bufferCount;
+        for (uint32_t i = 0; i < bufferCount; ++i)
+        {
+            pCache->pVertexBuffers[i] = ppBuffers[i];
+            pCache->mVertexStrides[i] = pStrides[i];
+            pCache->mVertexOffsets[i] = pOffsets ? pOffsets[i] : 0;
+        }
+    }
+}
+
+static inline void cmdStateBindIndexBuffer(CmdStateCache* pCache, Buffer* pBuffer, uint32_t indexType, uint64_t offset)
+{
+    const bool redundant = pCache->pIndexBuffer == pBuffer && pCache->mIndexType == indexType && pCache->mIndexOffset == offset;
+    if (cmdStateCount(pCache, CMD_STATE_BIND_INDEX_BUFFER, redundant))
+    {
+        cmdBindIndexBuffer(pCache->pCmd, pBuffer, indexType, offset);
+        pCache->pIndexBuffer = pBuffer;
+        pCache->mIndexType = indexType;
+        pCache->mIndexOffset = offset;
+    }
+}
+
+static inline void cmdStateSetViewport(CmdStateCache* pCache, float x, float y, float width, float height, float minDepth, float maxDepth)
+{
+    const float viewport[6] = { x, y, width, height, minDepth, maxDepth };
+    const bool  redundant = pCache->mViewportValid && memcmp(pCache->mViewport, viewport, sizeof(viewport)) == 0;
+    if (cmdStateCount(pCache, CMD_STATE_BIND_VIEWPORT, redundant))
+    {
+        cmdSetViewport(pCache->pCmd, x, y, width, height, minDepth, maxDepth);
+        memcpy(pCache->mViewport, viewport, sizeof(viewport));
+        pCache->mViewportValid = true;
+    }
+}
+
+static inline void cmdStateSetScissor(CmdStateCache* pCache, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+    const uint32_t scissor[4] = { x, y, width, height };
+    const bool     redundant = pCache->mScissorValid && memcmp(pCache->mScissor, scissor, sizeof(scissor)) == 0;
+    if (cmdStateCount(pCache, CMD_STATE_BIND_SCISSOR, redundant))
+    {
+        cmdSetScissor(pCache->pCmd, x, y, width, height);
+        memcpy(pCache->mScissor, scissor, sizeof(scissor));
+        pCache->mScissorValid = true;
+    }
+}
+
+static inline void cmdStateDraw(CmdStateCache* pCache, uint32_t vertexCount, uint32_t firstVertex)
+{
+    cmdDraw(pCache->pCmd, vertexCount, firstVertex);
+    if (pCache->pCounters)
+        ++pCache->pCounters->mDraws;
+}
+
+static inline void cmdStateDrawIndexedInstanced(CmdStateCache* pCache, uint32_t indexCount, uint32_t firstIndex, uint32_t instanceCount,
+                                                uint32_t firstVertex, uint32_t firstInstance)
+{
+    cmdDrawIndexedInstanced(pCache->pCmd, indexCount, firstIndex, instanceCount, firstVertex, firstInstance);
+    if (pCache->pCounters)
+        ++pCache->pCounters->mDraws;
+}
+
+// Moves the counts of the finished frame to pLastFrame and starts counting the next one
+static inline void cmdStateEndFrame(CmdStateCounters* pFrame, CmdStateCounters* pLastFrame)
+{
+    *pLastFrame = *pFrame;
+    *pFrame = {};
+}
+
+static inline void cmdStateFormatCounters(const CmdStateCounters* pCounters, char* pText, size_t size)
+{
+    uint32_t issued = 0;
+    uint32_t skipped = 0;
+    for (uint32_t i = 0; i < CMD_STATE_BIND_COUNT; ++i)
+    {
+        issued += pCounters->mIssued[i];
+        skipped += pCounters->mSkipped[i];
+    }
+    int length = snprintf(pText, size, "Binds: %u issued, %u skipped  Draws: %u  (", issued, skipped, pCounters->mDraws);
+    for (uint32_t i = 0; i < CMD_STATE_BIND_COUNT && length > 0 && (size_t)length < size; ++i)
+    {
+        length += snprintf(pText + length, size - length, "%s %u/%u%s", gCmdStateBindNames[i], pCounters->mIssued[i], pCounters->mSkipped[i],
+                           i + 1 < CMD_STATE_BIND_COUNT ? ", " : ")");
+    }
+}
@@ -0,0 +1,318 @@
+/*
+ * Copyright (c) 2017-2025 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+// GPU memory accounting for the resources a sample creates itself.
+// The gpuMemoryAdd*/gpuMemoryRemove* wrappers forward to addResource/addRenderTarget/removeResource and record
+// every allocation with a name and category. Live and peak bytes per category and the allocator's own
+// used/reserved figures (fragmentation) are available as overlay text, gpuMemoryLogReport() dumps the live set
+// sorted by size and gpuMemoryReloadCheckpoint() flags allocations that pile up across reload cycles.
+//
+// Sizes are the requested sizes (buffer size, sum of texture mips), alignment and allocator overhead show up
+// in the fragmentation figure instead. Textures are sized once their asynchronous load has created them.
+
+#include "../../../../Common_3/Graphics/Interfaces/IGraphics.h"
+#include "../../../../Common_3/Resources/ResourceLoader/Interfaces/IResourceLoader.h"
+#include "../../../../Common_3/Resources/ResourceLoader/ThirdParty/OpenSource/tinyimageformat/tinyimageformat_query.h"
+#include "../../../../Common_3/Utilities/Interfaces/ILog.h"
+
+#define GPU_MEMORY_MAX_ALLOCATIONS 256
+#define GPU_MEMORY_MAX_NAME        48
+#define GPU_MEMORY_MAX_CHECKPOINTS 8
+
+enum GpuMemoryCategory
+{
+    GPU_MEMORY_GEOMETRY,
+    GPU_MEMORY_UNIFORM,
+    GPU_MEMORY_TEXTURE,
+    GPU_MEMORY_RENDER_TARGET,
+    GPU_MEMORY_CATEGORY_COUNT
+};
+
+static const char* gGpuMemoryCategoryNames[GPU_MEMORY_CATEGORY_COUNT] = { "Geometry", "Uniforms", "Textures", "Render targets" };
+
+struct GpuMemoryAllocation
+{
+    const void* pResource;
+    Texture**   ppPendingTexture; // Set until the loader has created the texture and its size is known
+    uint64_t    mSize;
+    uint64_t    mSerial;
+    uint32_t    mCategory;
+    bool        mPendingRelease; // Retired, freed once the GPU is done with it
+    char        mName[GPU_MEMORY_MAX_NAME];
+};
+
+struct GpuMemoryTracker
+{
+    GpuMemoryAllocation mAllocations[GPU_MEMORY_MAX_ALLOCATIONS];
+    uint32_t            mAllocationCount;
+    uint64_t            mNextSerial;
+    uint64_t            mLiveBytes[GPU_MEMORY_CATEGORY_COUNT];
+    uint64_t            mPeakBytes[GPU_MEMORY_CATEGORY_COUNT];
+    uint64_t            mTotalLiveBytes;
+    uint64_t            mTotalPeakBytes;
+    // Live set after the previous Load() of each reload type, see gpuMemoryReloadCheckpoint()
+    uint32_t            mCheckpointType[GPU_MEMORY_MAX_CHECKPOINTS];
+    uint32_t            mCheckpointCount[GPU_MEMORY_MAX_CHECKPOINTS];
+    uint64_t            mCheckpointBytes[GPU_MEMORY_MAX_CHECKPOINTS];
+    uint64_t            mCheckpointSerial[GPU_MEMORY_MAX_CHECKPOINTS];
+    uint32_t            mCheckpointTypeCount;
+};
+
+static GpuMemoryTracker gGpuMemory = {};
+
+static inline double gpuMemoryToMB(uint64_t bytes) { return bytes / (1024.0 * 1024.0); }
+
+static inline uint64_t gpuMemoryImageSize(TinyImageFormat format, uint32_t width, uint32_t height, uint32_t depth, uint32_t arraySize,
+                                          uint32_t mipLevels, uint32_t sampleCount)
+{
+    const uint32_t blockWidth = TinyImageFormat_WidthOfBlock(format);
+    const uint32_t blockHeight = TinyImageFormat_HeightOfBlock(format);
+    const uint64_t blockBytes = TinyImageFormat_BitSizeOfBlock(format) / 8;
+    uint64_t       size = 0;
+    for (uint32_t mip = 0; mip < mipLevels; ++mip)
+    {
+        const uint32_t w = (width >> mip) ? (width >> mip) : 1u;
+        const uint32_t h = (height >> mip) ? (height >> mip) : 1u;
+        const uint32_t d = (depth >> mip) ? (depth >> mip) : 1u;
+        size += (uint64_t)((w + blockWidth - 1) / blockWidth) * ((h + blockHeight - 1) / blockHeight) * d * blockBytes;
+    }
+    return size * arraySize * sampleCount;
+}
+
+static inline void gpuMemoryAccount(uint32_t category, int64_t bytes)
+{
+    gGpuMemory.mLiveBytes[category] += bytes;
+    gGpuMemory.mTotalLiveBytes += bytes;
+    if (gGpuMemory.mLiveBytes[category] > gGpuMemory.mPeakBytes[category])
+        gGpuMemory.mPeakBytes[category] = gGpuMemory.mLiveBytes[category];
+    if (gGpuMemory.mTotalLiveBytes > gGpuMemory.mTotalPeakBytes)
+        gGpuMemory.mTotalPeakBytes = gGpuMemory.mTotalLiveBytes;
+}
+
+static inline void gpuMemoryRecord(const void* pResource, Texture** ppPendingTexture, uint64_t size, uint32_t category, const char* name)
+{
+    if (gGpuMemory.mAllocationCount == GPU_MEMORY_MAX_ALLOCATIONS)
+    {
+        LOGF(LogLevel::eWARNING, "GPU memory tracker full, %s is not tracked", name);
+        return;
+    }
+    GpuMemoryAllocation& allocation = gGpuMemory.mAllocations[gGpuMemory.mAllocationCount++];
+    allocation.pResource = pResource;
+    allocation.ppPendingTexture = ppPendingTexture;
+    allocation.mSize = size;
+    allocation.mSerial = gGpuMemory.mNextSerial++;
+    allocation.mCategory = category;
+    allocation.mPendingRelease = false;
+    snprintf(allocation.mName, sizeof(allocation.mName), "%s", name);
+    gpuMemoryAccount(category, (int64_t)size);
+}
+
+// A texture gpuMemoryUpdate() has not picked up yet is only known through its pending pointer
+static inline bool gpuMemoryMatches(const GpuMemoryAllocation& allocation, const void* pResource)
+{
+    return allocation.pResource == pResource || (allocation.ppPendingTexture && *allocation.ppPendingTexture == pResource);
+}
+
+static inline void gpuMemoryForget(const void* pResource)
+{
+    if (!pResource)
+        return;
+    for (uint32_t i = 0; i < gGpuMemory.mAllocationCount; ++i)
+    {
+        GpuMemoryAllocation& allocation = gGpuMemory.mAllocations[i];
+        if (!gpuMemoryMatches(allocation, pResource))
+            continue;
+        gpuMemoryAccount(allocation.mCategory, -(int64_t)allocation.mSize);
+        allocation = gGpuMemory.mAllocations[--gGpuMemory.mAllocationCount];
+        return;
+    }
+}
+
+// Deferred destruction: the memory stays live until the remove call, but the reload checkpoints ignore it
+static inline void gpuMemoryMarkPendingRelease(const void* pResource)
+{
+    if (!pResource)
+        return;
+    for (uint32_t i = 0; i < gGpuMemory.mAllocationCount; ++i)
+    {
+        if (gpuMemoryMatches(gGpuMemory.mAllocations[i], pResource))
+            gGpuMemory.mAllocations[i].mPendingRelease = true;
+    }
+}
+
+static inline void gpuMemoryAddBuffer(BufferLoadDesc* pDesc, SyncToken* pToken, const char* name, GpuMemoryCategory category)
+{
+    addResource(pDesc, pToken);
+    gpuMemoryRecord(*pDesc->ppBuffer, NULL, pDesc->mDesc.mSize, category, name);
+}
+
+static inline void gpuMemoryAddTexture(TextureLoadDesc* pDesc, SyncToken* pToken, const char* name)
+{
+    addResource(pDesc, pToken);
+    gpuMemoryRecord(NULL, pDesc->ppTexture, 0, GPU_MEMORY_TEXTURE, name);
+}
+
+static inline void gpuMemoryAddRenderTarget(Renderer* pRenderer, const RenderTargetDesc* pDesc, RenderTarget** ppRenderTarget,
+                                            const char* name)
+{
+    addRenderTarget(pRenderer, pDesc, ppRenderTarget);
+    if (!*ppRenderTarget)
+        return;
+    const uint64_t size = gpuMemoryImageSize(pDesc->mFormat, pDesc->mWidth, pDesc->mHeight, pDesc->mDepth, pDesc->mArraySize,
+                                             pDesc->mMipLevels ? pDesc->mMipLevels : 1u, (uint32_t)pDesc->mSampleCount);
+    gpuMemoryRecord(*ppRenderTarget, NULL, size, GPU_MEMORY_RENDER_TARGET, name);
+}
+
+static inline void gpuMemoryRemoveBuffer(Buffer* pBuffer)
+{
+    gpuMemoryForget(pBuffer);
+    removeResource(pBuffer);
+}
+
+static inline void gpuMemoryRemoveTexture(Texture* pTexture)
+{
+    gpuMemoryForget(pTexture);
+    removeResource(pTexture);
+}
+
+static inline void gpuMemoryRemoveRenderTarget(Renderer* pRenderer, RenderTarget* pRenderTarget)
+{
+    gpuMemoryForget(pRenderTarget);
+    removeRenderTarget(pRenderer, pRenderTarget);
+}
+
+// Picks up the sizes of textures whose load has completed
+static inline void gpuMemoryUpdate()
+{
+    for (uint32_t i = 0; i < gGpuMemory.mAllocationCount; ++i)
+    {
+        GpuMemoryAllocation& allocation = gGpuMemory.mAllocations[i];
+        if (!allocation.ppPendingTexture || !*allocation.ppPendingTexture)
+            continue;
+        const Texture* pTexture = *allocation.ppPendingTexture;
+        allocation.pResource = pTexture;
+        allocation.ppPendingTexture = NULL;
+        allocation.mSize = gpuMemoryImageSize((TinyImageFormat)pTexture->mFormat, pTexture->mWidth, pTexture->mHeight, pTexture->mDepth,
+                                              pTexture->mArraySizeMinusOne + 1, pTexture->mMipLevels, 1);
+        gpuMemoryAccount(allocation.mCategory, (int64_t)allocation.mSize);
+    }
+}
+
+static inline void gpuMemoryFormatText(Renderer* pRenderer, bstring* pText)
+{
+    uint64_t usedBytes = 0;
+    uint64_t reservedBytes = 0;
+    calculateMemoryUse(pRenderer, &usedBytes, &reservedBytes);
+
+    bformat(pText, "\nGPU Memory (live / peak):\n");
+    for (uint32_t c = 0; c < GPU_MEMORY_CATEGORY_COUNT; ++c)
+    {
+        bformata(pText, "    %-16s %8.2f MB / %8.2f MB\n", gGpuMemoryCategoryNames[c], gpuMemoryToMB(gGpuMemory.mLiveBytes[c]),
+                 gpuMemoryToMB(gGpuMemory.mPeakBytes[c]));
+    }
+    bformata(pText, "    %-16s %8.2f MB / %8.2f MB (%u allocations)\n", "Total", gpuMemoryToMB(gGpuMemory.mTotalLiveBytes),
+             gpuMemoryToMB(gGpuMemory.mTotalPeakBytes), gGpuMemory.mAllocationCount);
+    bformata(pText, "    Allocator: %.2f MB used of %.2f MB reserved, %.1f%% fragmentation\n", gpuMemoryToMB(usedBytes),
+             gpuMemoryToMB(reservedBytes), reservedBytes ? 100.0 * (double)(reservedBytes - usedBytes) / (double)reservedBytes : 0.0);
+}
+
+static inline void gpuMemoryLogReport(const char* appName)
+{
+    // Indices sorted by size, largest first
+    uint32_t order[GPU_MEMORY_MAX_ALLOCATIONS];
+    for (uint32_t i = 0; i < gGpuMemory.mAllocationCount; ++i)
+    {
+        uint32_t j = i;
+        for (; j > 0 && gGpuMemory.mAllocations[order[j - 1]].mSize < gGpuMemory.mAllocations[i].mSize; --j)
+            order[j] = order[j - 1];
+        order[j] = i;
+    }
+
+    LOGF(LogLevel::eINFO, "%s GPU memory: %u allocations, %.2f MB live, %.2f MB peak", appName, gGpuMemory.mAllocationCount,
+         gpuMemoryToMB(gGpuMemory.mTotalLiveBytes), gpuMemoryToMB(gGpuMemory.mTotalPeakBytes));
+    for (uint32_t i = 0; i < gGpuMemory.mAllocationCount; ++i)
+    {
+        const GpuMemoryAllocation& allocation = gGpuMemory.mAllocations[order[i]];
+        LOGF(LogLevel::eINFO, "    %10.3f KB  %-16s %s%s", allocation.mSize / 1024.0, gGpuMemoryCategoryNames[allocation.mCategory],
+             allocation.mName, allocation.ppPendingTexture ? " (still loading)" : "");
+    }
+}
+
+// Call at the end of Load(): after an Unload/Load cycle of the same type the live set has to match the one
+// after the previous cycle, anything on top was created by Load() and never released by Unload()
+static inline void gpuMemoryReloadCheckpoint(uint32_t reloadType)
+{
+    uint32_t slot = 0;
+    while (slot < gGpuMemory.mCheckpointTypeCount && gGpuMemory.mCheckpointType[slot] != reloadType)
+        ++slot;
+    if (slot == GPU_MEMORY_MAX_CHECKPOINTS)
+        return;
+
+    uint32_t liveCount = 0;
+    uint64_t liveBytes = 0;
+    for (uint32_t i = 0; i < gGpuMemory.mAllocationCount; ++i)
+    {
+        if (!gGpuMemory.mAllocations[i].mPendingRelease)
+        {
+            ++liveCount;
+            liveBytes += gGpuMemory.mAllocations[i].mSize;
+        }
+    }
+
+    if (slot == gGpuMemory.mCheckpointTypeCount)
+    {
+        ++gGpuMemory.mCheckpointTypeCount;
+        gGpuMemory.mCheckpointType[slot] = reloadType;
+    }
+    else if (liveCount > gGpuMemory.mCheckpointCount[slot])
+    {
+        LOGF(LogLevel::eWARNING, "GPU memory leak across reload (type 0x%x): %u more allocations than after the previous one, %+.3f KB",
+             reloadType, liveCount - gGpuMemory.mCheckpointCount[slot], ((int64_t)liveBytes - (int64_t)gGpuMemory.mCheckpointBytes[slot]) / 1024.0);
+        // The leaked allocations are among the ones this cycle created
+        for (uint32_t i = 0; i < gGpuMemory.mAllocationCount; ++i)
+        {
+            const GpuMemoryAllocation& allocation = gGpuMemory.mAllocations[i];
+            if (!allocation.mPendingRelease && allocation.mSerial >= gGpuMemory.mCheckpointSerial[slot])
+                LOGF(LogLevel::eWARNING, "    created this cycle: %s (%s, %.3f KB)", allocation.mName,
+                     gGpuMemoryCategoryNames[allocation.mCategory], allocation.mSize / 1024.0);
+        }
+    }
+
+    gGpuMemory.mCheckpointCount[slot] = liveCount;
+    gGpuMemory.mCheckpointBytes[slot] = liveBytes;
+    gGpuMemory.mCheckpointSerial[slot] = gGpuMemory.mNextSerial;
+}
+
+// Call at the very end of Exit()
+static inline void gpuMemoryCheckLeaks(const char* appName)
+{
+    for (uint32_t i = 0; i < gGpuMemory.mAllocationCount; ++i)
+    {
+        const GpuMemoryAllocation& allocation = gGpuMemory.mAllocations[i];
+        LOGF(LogLevel::eWARNING, "%s GPU memory leak: %s (%s, %.3f KB)", appName, allocation.mName,
+             gGpuMemoryCategoryNames[allocation.mCategory], allocation.mSize / 1024.0);
+    }
+}
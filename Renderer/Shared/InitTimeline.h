@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2017-2025 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+// Wall clock breakdown of a sample's Init().
+// initTimelineMark() closes the phase that started at the previous mark, logInitTimeline() prints one line per
+// phase plus the total against the sample's cold start budget.
+
+#include "../../../../Common_3/Utilities/Interfaces/ILog.h"
+#include "../../../../Common_3/Utilities/Interfaces/ITime.h"
+
+#define INIT_TIMELINE_MAX_PHASES 16
+
+struct InitTimeline
+{
+    const char* pPhaseNames[INIT_TIMELINE_MAX_PHASES];
+    int64_t     mPhaseEnd[INIT_TIMELINE_MAX_PHASES];
+    int64_t     mStart;
+    uint32_t    mPhaseCount;
+};
+
+static inline void initTimelineBegin(InitTimeline* pTimeline)
+{
+    pTimeline->mPhaseCount = 0;
+    pTimeline->mStart = getUSec(true);
+}
+
+static inline void initTimelineMark(InitTimeline* pTimeline, const char* pPhaseName)
+{
+    ASSERT(pTimeline->mPhaseCount < INIT_TIMELINE_MAX_PHASES);
+    pTimeline->pPhaseNames[pTimeline->mPhaseCount] = pPhaseName;
+    pTimeline->mPhaseEnd[pTimeline->mPhaseCount] = getUSec(true);
+    ++pTimeline->mPhaseCount;
+}
+
+static inline void logInitTimeline(const InitTimeline* pTimeline, const char* appName, float budgetMs)
+{
+    int64_t phaseStart = pTimeline->mStart;
+    for (uint32_t i = 0; i < pTimeline->mPhaseCount; ++i)
+    {
+        LOGF(LogLevel::eINFO, "%s Init: %-16s %8.2f ms  (at %8.2f ms)", appName, pTimeline->pPhaseNames[i],
+             (pTimeline->mPhaseEnd[i] - phaseStart) / 1000.0f, (pTimeline->mPhaseEnd[i] - pTimeline->mStart) / 1000.0f);
+        phaseStart = pTimeline->mPhaseEnd[i];
+    }
+
+    const float totalMs = pTimeline->mPhaseCount ? (pTimeline->mPhaseEnd[pTimeline->mPhaseCount - 1] - pTimeline->mStart) / 1000.0f : 0.0f;
+    LOGF(totalMs > budgetMs ? LogLevel::eWARNING : LogLevel::eINFO, "%s Init: total %.2f ms (budget %.0f ms)", appName, totalMs,
+         budgetMs);
+}
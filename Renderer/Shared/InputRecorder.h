@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2017-2025 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+// Deterministic input capture and replay for benchmark runs.
+// Every frame the app routes the input values it consumes through inputRecordFloat()/inputRecordBits() on a fixed
+// channel index, and its discrete events (touches) through inputRecordEvent(). Capture writes the frame's deltaTime,
+// the channels that changed since the previous frame and the events to <file> in RD_LOG; replay reads the same file
+// back and returns the recorded values instead of the live ones. An optional fixed timestep replaces deltaTime in
+// both modes, so two replays of one recording drive exactly the same frames.
+//
+// File: InputRecordHeader, then per frame: uint64 changed channel mask, float deltaTime, uint32 event count, one
+// 32-bit word per changed channel (floats as their bits) and the events.
+
+#include "../../../../Common_3/Utilities/Interfaces/IFileSystem.h"
+#include "../../../../Common_3/Utilities/Interfaces/ILog.h"
+
+#define INPUT_RECORD_MAGIC           0x524E4946 // "FINR"
+#define INPUT_RECORD_VERSION         1
+#define INPUT_RECORD_MAX_CHANNELS    64
+#define INPUT_RECORD_MAX_EVENT_BYTES 4096
+
+enum InputRecordMode
+{
+    INPUT_RECORD_OFF,
+    INPUT_RECORD_CAPTURE,
+    INPUT_RECORD_REPLAY,
+};
+
+struct InputRecordHeader
+{
+    uint32_t mMagic;
+    uint32_t mVersion;
+    uint32_t mChannelCount;
+    uint32_t mEventSize;
+};
+
+struct InputRecordFrame
+{
+    uint64_t mChangedMask;
+    float    mDeltaTime;
+    uint32_t mEventCount;
+};
+
+struct InputRecorder
+{
+    FileStream      mStream;
+    InputRecordMode mMode;
+    uint32_t        mChannelCount;
+    uint32_t        mEventSize;
+    float           mFixedDeltaTime; // 0 keeps the live (capture) or recorded (replay) deltaTime
+    uint32_t        mFrame;
+    float           mDeltaTime;
+    uint64_t        mChangedMask;
+    uint32_t        mWords[INPUT_RECORD_MAX_CHANNELS]; // Value of every channel in the current frame
+    uint32_t        mEventCount;
+    uint32_t        mNextEvent; // Replay read position in mEvents
+    uint8_t         mEvents[INPUT_RECORD_MAX_EVENT_BYTES];
+};
+
+struct InputRecordArgs
+{
+    InputRecordMode mMode;
+    const char*     pFileName;
+    float           mFixedDeltaTime;
+};
+
+// Consumes --record-input <file>, --replay-input <file> and --fixed-timestep <ms>, returns false for anything else
+static inline bool inputRecordParseArg(int argc, const char* const* argv, int* pIndex, InputRecordArgs* pArgs)
+{
+    const char* arg = argv[*pIndex];
+    if (*pIndex + 1 >= argc)
+        return false;
+    if (strcmp(arg, "--record-input") == 0 || strcmp(arg, "--replay-input") == 0)
+    {
+        pArgs->mMode = strcmp(arg, "--record-input") == 0 ? INPUT_RECORD_CAPTURE : INPUT_RECORD_REPLAY;
+        pArgs->pFileName = argv[++*pIndex];
+        return true;
+    }
+    if (strcmp(arg, "--fixed-timestep") == 0)
+    {
+        pArgs->mFixedDeltaTime = (float)atof(argv[++*pIndex]) / 1000.0f;
+        return true;
+    }
+    return false;
+}
+
+static inline bool initInputRecorder(InputRecorder* pRecorder, InputRecordMode mode, const char* fileName, uint32_t channelCount,
+                                     uint32_t eventSize, float fixedDeltaTime)
+{
+    ASSERT(channelCount <= INPUT_RECORD_MAX_CHANNELS && eventSize <= INPUT_RECORD_MAX_EVENT_BYTES);
+    *pRecorder = {};
+    pRecorder->mChannelCount = channelCount;
+    pRecorder->mEventSize = eventSize;
+    pRecorder->mFixedDeltaTime = fixedDeltaTime;
+    if (mode == INPUT_RECORD_OFF)
+        return true;
+
+    if (!fsOpenStreamFromPath(RD_LOG, fileName, mode == INPUT_RECORD_CAPTURE ? FM_WRITE : FM_READ, &pRecorder->mStream))
+    {
+        LOGF(LogLevel::eERROR, "Could not open input recording '%s'", fileName);
+        return false;
+    }
+
+    InputRecordHeader header = { INPUT_RECORD_MAGIC, INPUT_RECORD_VERSION, channelCount, eventSize };
+    if (mode == INPUT_RECORD_CAPTURE)
+    {
+        fsWriteToStream(&pRecorder->mStream, &header, sizeof(header));
+    }
+    else
+    {
+        InputRecordHeader fileHeader = {};
+        if (fsReadFromStream(&pRecorder->mStream, &fileHeader, sizeof(fileHeader)) != sizeof(fileHeader) ||
+            memcmp(&fileHeader, &header, sizeof(header)) != 0)
+        {
+            LOGF(LogLevel::eERROR, "Input recording '%s' was made by a different build or sample", fileName);
+            fsCloseStream(&pRecorder->mStream);
+            return false;
+        }
+    }
+    pRecorder->mMode = mode;
+    LOGF(LogLevel::eINFO, "Input %s '%s'%s", mode == INPUT_RECORD_CAPTURE ? "capture to" : "replay from", fileName,
+         fixedDeltaTime > 0.0f ? " with a fixed timestep" : "");
+    return true;
+}
+
+static inline void exitInputRecorder(InputRecorder* pRecorder)
+{
+    if (pRecorder->mMode != INPUT_RECORD_OFF)
+    {
+        LOGF(LogLevel::eINFO, "Input %s: %u frames", pRecorder->mMode == INPUT_RECORD_CAPTURE ? "capture" : "replay", pRecorder->mFrame);
+        fsCloseStream(&pRecorder->mStream);
+    }
+    pRecorder->mMode = INPUT_RECORD_OFF;
+}
+
+// Call before reading any channel. Returns false once a replay ran out of frames (the recorder is off from then on).
+static inline bool inputRecordBeginFrame(InputRecorder* pRecorder, float* pDeltaTime)
+{
+    if (pRecorder->mFixedDeltaTime > 0.0f)
+        *pDeltaTime = pRecorder->mFixedDeltaTime;
+
+    pRecorder->mDeltaTime = *pDeltaTime;
+    pRecorder->mChangedMask = 0;
+    pRecorder->mEventCount = 0;
+    pRecorder->mNextEvent = 0;
+    if (pRecorder->mMode != INPUT_RECORD_REPLAY)
+        return true;
+
+    InputRecordFrame frame = {};
+    bool valid = fsReadFromStream(&pRecorder->mStream, &frame, sizeof(frame)) == sizeof(frame) &&
+                 frame.mEventCount * pRecorder->mEventSize <= INPUT_RECORD_MAX_EVENT_BYTES;
+    for (uint32_t i = 0; valid && i < pRecorder->mChannelCount; ++i)
+    {
+        if (frame.mChangedMask & (1ull << i))
+            valid = fsReadFromStream(&pRecorder->mStream, &pRecorder->mWords[i], sizeof(uint32_t)) == sizeof(uint32_t);
+    }
+    const size_t eventBytes = (size_t)frame.mEventCount * pRecorder->mEventSize;
+    valid = valid && fsReadFromStream(&pRecorder->mStream, pRecorder->mEvents, eventBytes) == eventBytes;
+    if (!valid)
+    {
+        exitInputRecorder(pRecorder);
+        return false;
+    }
+
+    if (pRecorder->mFixedDeltaTime <= 0.0f)
+        *pDeltaTime = frame.mDeltaTime;
+    pRecorder->mChangedMask = frame.mChangedMask;
+    pRecorder->mEventCount = frame.mEventCount;
+    ++pRecorder->mFrame;
+    return true;
+}
+
+// Returns the recorded value during replay and the live one otherwise
+static inline uint32_t inputRecordBits(InputRecorder* pRecorder, uint32_t channel, uint32_t live)
+{
+    ASSERT(channel < pRecorder->mChannelCount);
+    if (pRecorder->mMode == INPUT_RECORD_REPLAY)
+        return pRecorder->mWords[channel];
+    if (pRecorder->mMode == INPUT_RECORD_CAPTURE && pRecorder->mWords[channel] != live)
+    {
+        pRecorder->mWords[channel] = live;
+        pRecorder->mChangedMask |= 1ull << channel;
+    }
+    return live;
+}
+
+static inline float inputRecordFloat(InputRecorder* pRecorder, uint32_t channel, float live)
+{
+    uint32_t bits;
+    memcpy(&bits, &live, sizeof(bits));
+    bits = inputRecordBits(pRecorder, channel, bits);
+    memcpy(&live, &bits, sizeof(bits));
+    return live;
+}
+
+static inline void inputRecordEvent(InputRecorder* pRecorder, const void* pEvent)
+{
+    if (pRecorder->mMode != INPUT_RECORD_CAPTURE)
+        return;
+    if ((pRecorder->mEventCount + 1) * pRecorder->mEventSize > INPUT_RECORD_MAX_EVENT_BYTES)
+    {
+        LOGF(LogLevel::eWARNING, "Input capture: too many events in frame %u, dropping", pRecorder->mFrame);
+        return;
+    }
+    memcpy(pRecorder->mEvents + pRecorder->mEventCount * pRecorder->mEventSize, pEvent, pRecorder->mEventSize);
+    ++pRecorder->mEventCount;
+}
+
+// Replay: copies the next recorded event of this frame, returns false when there are no more
+static inline bool inputRecordNextEvent(InputRecorder* pRecorder, void* pEvent)
+{
+    if (pRecorder->mMode != INPUT_RECORD_REPLAY || pRecorder->mNextEvent == pRecorder->mEventCount)
+        return false;
+    memcpy(pEvent, pRecorder->mEvents + pRecorder->mNextEvent * pRecorder->mEventSize, pRecorder->mEventSize);
+    ++pRecorder->mNextEvent;
+    return true;
+}
+
+// Capture: writes the frame, call after the last channel and event
+static inline void inputRecordEndFrame(InputRecorder* pRecorder)
+{
+    if (pRecorder->mMode != INPUT_RECORD_CAPTURE)
+        return;
+
+    InputRecordFrame frame = { pRecorder->mChangedMask, pRecorder->mDeltaTime, pRecorder->mEventCount };
+    fsWriteToStream(&pRecorder->mStream, &frame, sizeof(frame));
+    for (uint32_t i = 0; i < pRecorder->mChannelCount; ++i)
+    {
+        if (pRecorder->mChangedMask & (1ull << i))
+            fsWriteToStream(&pRecorder->mStream, &pRecorder->mWords[i], sizeof(uint32_t));
+    }
+    fsWriteToStream(&pRecorder->mStream, pRecorder->mEvents, (size_t)pRecorder->mEventCount * pRecorder->mEventSize);
+    ++pRecorder->mFrame;
+}
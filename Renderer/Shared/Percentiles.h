@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2017-2025 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+// Min / average / percentiles of a timing history, shared by the samples that report latency distributions.
+// getPercentiles() sorts the array it is given in place, callers pass a copy when the history keeps its order.
+
+#include <stdlib.h> // qsort
+
+struct Percentiles
+{
+    float mMin;
+    float mAvg;
+    float mP50;
+    float mP95;
+    float mP99;
+    float mMax;
+};
+
+static inline int comparePercentileSamples(const void* pA, const void* pB)
+{
+    const float a = *(const float*)pA;
+    const float b = *(const float*)pB;
+    return (a > b) - (a < b);
+}
+
+static inline Percentiles getPercentiles(float* pSamples, uint32_t count)
+{
+    Percentiles result = {};
+    if (!count)
+        return result;
+
+    double total = 0.0;
+    for (uint32_t i = 0; i < count; ++i)
+        total += pSamples[i];
+    qsort(pSamples, count, sizeof(float), comparePercentileSamples);
+
+    result.mMin = pSamples[0];
+    result.mAvg = (float)(total / count);
+    result.mP50 = pSamples[count / 2];
+    result.mP95 = pSamples[(count * 95) / 100];
+    result.mP99 = pSamples[(count * 99) / 100];
+    result.mMax = pSamples[count - 1];
+    return result;
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2017-2025 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#pragma once
+
+// File name of a sample's persistent pipeline cache.
+// The cache blob is only valid for the device and driver that produced it, so both are part of the file name.
+// A driver update or a different GPU simply starts from a cold cache instead of feeding a foreign blob to the driver.
+
+#include "../../../../Common_3/Graphics/Interfaces/IGraphics.h"
+
+static inline void getPipelineCacheName(Renderer* pRenderer, const char* appName, char* outName, size_t outSize)
+{
+    const GPUVendorPreset& preset = pRenderer->pGpu->mGpuVendorPreset;
+    uint32_t               driverHash = 2166136261u; // FNV-1a
+    for (const char* c = preset.mGpuDriverVersion; *c; ++c)
+        driverHash = (driverHash ^ (uint8_t)*c) * 16777619u;
+    snprintf(outName, outSize, "%s_%04x_%04x_%08x.cache", appName, preset.mVendorId, preset.mModelId, driverHash);
+}
@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) 2017-2025 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+// Packed shader binary archive.
+// Tools/pack_shaders.py bakes every #vert/#frag/#comp entry of a sample's shaders.list into a single
+// <AppName>.shaderpak next to the regular shader binaries. The file is memory mapped once and each shader
+// becomes a binary search in the entry table instead of a file system lookup and open per stage.
+//
+// Layout (little endian, blobs 16 byte aligned):
+//   ShaderArchiveHeader
+//   ShaderArchiveEntry[mEntryCount]   sorted by mNameHash
+//   FSL binary blobs                  identical blobs are stored once (keyed by mContentHash)
+//
+// The reload server only rewrites the loose binaries, so on reload every entry is checked against the hash of its
+// loose binary and an archive that was not re-packed since is bypassed instead of handing out stale shaders.
+
+#include "../../../../Common_3/Graphics/Interfaces/IGraphics.h"
+#include "../../../../Common_3/Resources/ResourceLoader/Interfaces/IResourceLoader.h"
+#include "../../../../Common_3/Utilities/Interfaces/IFileSystem.h"
+#include "../../../../Common_3/Utilities/Interfaces/ILog.h"
+
+#define SHADER_ARCHIVE_MAGIC    0x4B505346u // "FSPK"
+#define SHADER_ARCHIVE_VERSION  2u
+#define SHADER_ARCHIVE_MAX_NAME 64
+
+// The FSL compiler tags each derivative with the hash of its feature set, FT_MULTIVIEW being the multiview
+// stage load flag. The resource loader selects the derivative by that hash and so does the archive.
+#if defined(QUEST_VR)
+#define SHADER_ARCHIVE_DERIVATIVE_HASH ((uint64_t)SHADER_STAGE_LOAD_FLAG_ENABLE_VR_MULTIVIEW)
+#else
+#define SHADER_ARCHIVE_DERIVATIVE_HASH 0ull
+#endif
+
+struct ShaderArchiveHeader
+{
+    uint32_t mMagic;
+    uint32_t mVersion;
+    uint32_t mEntryCount;
+    uint32_t mReserved;
+};
+
+struct ShaderArchiveEntry
+{
+    uint64_t mNameHash;
+    uint64_t mContentHash; // compiled blob, compared against the loose binary on reload
+    uint32_t mOffset;
+    uint32_t mSize;
+    char     mName[SHADER_ARCHIVE_MAX_NAME];
+};
+
+struct ShaderArchive
+{
+    FileStream                mStream;
+    const uint8_t*            pData;
+    size_t                    mSize;
+    const ShaderArchiveEntry* pEntries;
+    uint32_t                  mEntryCount;
+};
+
+// Must match name_hash() in Tools/pack_shaders.py
+static inline uint64_t shaderArchiveNameHash(const char* name)
+{
+    uint64_t hash = 14695981039346656037ull; // FNV-1a
+    for (const char* c = name; *c; ++c)
+        hash = (hash ^ (uint8_t)*c) * 1099511628211ull;
+    return hash;
+}
+
+// Must match content_hash() in Tools/pack_shaders.py
+static inline uint64_t shaderArchiveContentHash(const void* pData, size_t size)
+{
+    const uint8_t* pBytes = (const uint8_t*)pData;
+    uint64_t       hash = 14695981039346656037ull; // FNV-1a
+    for (size_t i = 0; i < size; ++i)
+        hash = (hash ^ pBytes[i]) * 1099511628211ull;
+    return hash;
+}
+
+static inline uint64_t combineShaderHashes(uint64_t vert, uint64_t frag)
+{
+    if (!vert || !frag)
+        return 0;
+    return vert ^ (frag * 1099511628211ull);
+}
+
+// Content hash of the loose binary the FSL compiler or the reload server last wrote, 0 if there is none
+static inline uint64_t getShaderBinaryHash(const char* name)
+{
+    FileStream stream = {};
+    if (!fsOpenStreamFromPath(RD_SHADER_BINARIES, name, FM_READ, &stream))
+        return 0;
+
+    uint64_t    hash = 0;
+    size_t      size = 0;
+    const void* pData = NULL;
+    if (fsStreamMemoryMap(&stream, &size, &pData))
+        hash = shaderArchiveContentHash(pData, size);
+    fsCloseStream(&stream);
+    return hash;
+}
+
+static inline bool openShaderArchive(const char* appName, ShaderArchive* pArchive)
+{
+    *pArchive = {};
+
+    char fileName[FS_MAX_PATH] = {};
+    snprintf(fileName, TF_ARRAY_COUNT(fileName), "%s.shaderpak", appName);
+    if (!fsOpenStreamFromPath(RD_SHADER_BINARIES, fileName, FM_READ, &pArchive->mStream))
+        return false;
+
+    const void* pData = NULL;
+    if (!fsStreamMemoryMap(&pArchive->mStream, &pArchive->mSize, &pData) || pArchive->mSize < sizeof(ShaderArchiveHeader))
+    {
+        fsCloseStream(&pArchive->mStream);
+        *pArchive = {};
+        return false;
+    }
+
+    const ShaderArchiveHeader* pHeader = (const ShaderArchiveHeader*)pData;
+    if (pHeader->mMagic != SHADER_ARCHIVE_MAGIC || pHeader->mVersion != SHADER_ARCHIVE_VERSION ||
+        sizeof(ShaderArchiveHeader) + pHeader->mEntryCount * sizeof(ShaderArchiveEntry) > pArchive->mSize)
+    {
+        LOGF(LogLevel::eWARNING, "Ignoring shader archive '%s': unsupported version or truncated file", fileName);
+        fsCloseStream(&pArchive->mStream);
+        *pArchive = {};
+        return false;
+    }
+
+    pArchive->pData = (const uint8_t*)pData;
+    pArchive->pEntries = (const ShaderArchiveEntry*)(pHeader + 1);
+    pArchive->mEntryCount = pHeader->mEntryCount;
+    return true;
+}
+
+static inline void closeShaderArchive(ShaderArchive* pArchive)
+{
+    if (pArchive->pData)
+        fsCloseStream(&pArchive->mStream);
+    *pArchive = {};
+}
+
+static inline const ShaderArchiveEntry* findShaderArchiveEntry(const ShaderArchive* pArchive, const char* name)
+{
+    const uint64_t nameHash = shaderArchiveNameHash(name);
+    uint32_t       first = 0;
+    uint32_t       last = pArchive->mEntryCount;
+    while (first < last)
+    {
+        const uint32_t mid = first + (last - first) / 2;
+        if (pArchive->pEntries[mid].mNameHash < nameHash)
+            first = mid + 1;
+        else
+            last = mid;
+    }
+    if (first < pArchive->mEntryCount && pArchive->pEntries[first].mNameHash == nameHash)
+        return &pArchive->pEntries[first];
+    return NULL;
+}
+
+// Combined content hash of a vert/frag pair in the archive, 0 if either stage is missing from it
+static inline uint64_t getShaderArchiveContentHash(const ShaderArchive* pArchive, const char* vert, const char* frag)
+{
+    const ShaderArchiveEntry* pVert = findShaderArchiveEntry(pArchive, vert);
+    const ShaderArchiveEntry* pFrag = findShaderArchiveEntry(pArchive, frag);
+    if (!pVert || !pFrag)
+        return 0;
+    return combineShaderHashes(pVert->mContentHash, pFrag->mContentHash);
+}
+
+// Hash of the binaries a vert/frag pair would be built from now: the loose binaries when they exist, otherwise the
+// archive's copy (builds that only ship the archive). Only reloads call it, the first load trusts the archive.
+static inline uint64_t getShaderPairHash(const ShaderArchive* pArchive, const char* vert, const char* frag)
+{
+    const uint64_t binaryHash = combineShaderHashes(getShaderBinaryHash(vert), getShaderBinaryHash(frag));
+    return binaryHash ? binaryHash : getShaderArchiveContentHash(pArchive, vert, frag);
+}
+
+static inline bool getShaderArchiveStage(const ShaderArchive* pArchive, const char* name, BinaryShaderStageDesc* pOut)
+{
+    const ShaderArchiveEntry* pEntry = findShaderArchiveEntry(pArchive, name);
+    if (!pEntry || (size_t)pEntry->mOffset + pEntry->mSize > pArchive->mSize)
+        return false;
+
+    // Blobs are stored exactly as the FSL compiler wrote them; pick the derivative the same way the resource loader does
+    const uint8_t*       pBlob = pArchive->pData + pEntry->mOffset;
+    const FSLHeader*     pHeader = (const FSLHeader*)pBlob;
+    const FSLDerivative* pDerivatives = (const FSLDerivative*)(pHeader + 1);
+    if (memcmp(pHeader->mMagic, "@FSL", 4) != 0)
+        return false;
+
+    for (uint32_t i = 0; i < pHeader->mDerivativeCount; ++i)
+    {
+        const FSLDerivative& derivative = pDerivatives[i];
+        if (derivative.mHash != SHADER_ARCHIVE_DERIVATIVE_HASH || (size_t)derivative.mOffset + derivative.mSize > pEntry->mSize)
+            continue;
+        pOut->pName = pEntry->mName;
+        pOut->pByteCode = (void*)(pBlob + derivative.mOffset);
+        pOut->mByteCodeSize = (uint32_t)derivative.mSize;
+        pOut->pEntryPoint = "main";
+        return true;
+    }
+    // No derivative for this feature set, the resource loader reports that properly
+    return false;
+}
+
+// Returns false when either stage is not in the archive so the caller can fall back to addShader by file name
+static inline bool addShaderFromArchive(Renderer* pRenderer, const ShaderArchive* pArchive, const char* vert, const char* frag,
+                                        Shader** ppShader)
+{
+    if (!pArchive->pData)
+        return false;
+
+    BinaryShaderDesc binaryDesc = {};
+    binaryDesc.mStages = SHADER_STAGE_VERT | SHADER_STAGE_FRAG;
+    if (!getShaderArchiveStage(pArchive, vert, &binaryDesc.mVert) || !getShaderArchiveStage(pArchive, frag, &binaryDesc.mFrag))
+        return false;
+
+    addShaderBinary(pRenderer, &binaryDesc, ppShader);
+    return *ppShader != NULL;
+}
+
+// Creates a vert/frag pair from the archive when its copy is the one binaryHash describes (0 when the caller has
+// nothing to check against), otherwise from the loose binaries by name. Returns the hash the shader was built from.
+static inline uint64_t addShaderPair(Renderer* pRenderer, const ShaderArchive* pArchive, const char* vert, const char* frag,
+                                     uint64_t binaryHash, Shader** ppShader)
+{
+    const uint64_t archiveHash = getShaderArchiveContentHash(pArchive, vert, frag);
+    if (archiveHash && (!binaryHash || binaryHash == archiveHash) && addShaderFromArchive(pRenderer, pArchive, vert, frag, ppShader))
+        return archiveHash;
+
+    ShaderLoadDesc shaderDesc = {};
+    shaderDesc.mVert.pFileName = vert;
+    shaderDesc.mFrag.pFileName = frag;
+    addShader(pRenderer, &shaderDesc, ppShader);
+    return binaryHash;
+}
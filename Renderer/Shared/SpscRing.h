@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2017-2025 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+// Wait-free single producer / single consumer ring.
+// spscPush() is only called from the producer thread and spscPop() only from the consumer. Neither ever blocks or
+// retries: a push into a full ring fails and the producer decides whether to drop or count the item. Head and tail
+// are free running counters, so Capacity must be a power of two.
+
+#include "../../../../Common_3/Utilities/Threading/Atomics.h"
+
+template<typename T, uint32_t Capacity> struct SpscRing
+{
+    COMPILE_ASSERT(Capacity && (Capacity & (Capacity - 1)) == 0);
+
+    T               mItems[Capacity];
+    tfrg_atomic32_t mHead; // Next slot the producer writes
+    tfrg_atomic32_t mTail; // Next slot the consumer reads
+};
+
+template<typename T, uint32_t Capacity> static inline bool spscPush(SpscRing<T, Capacity>* pRing, const T& item)
+{
+    const uint32_t head = tfrg_atomic32_load_relaxed(&pRing->mHead);
+    if (head - tfrg_atomic32_load_acquire(&pRing->mTail) == Capacity)
+        return false;
+    pRing->mItems[head & (Capacity - 1)] = item;
+    tfrg_atomic32_store_release(&pRing->mHead, head + 1);
+    return true;
+}
+
+template<typename T, uint32_t Capacity> static inline bool spscPop(SpscRing<T, Capacity>* pRing, T* pItem)
+{
+    const uint32_t tail = tfrg_atomic32_load_relaxed(&pRing->mTail);
+    if (tail == tfrg_atomic32_load_acquire(&pRing->mHead))
+        return false;
+    *pItem = pRing->mItems[tail & (Capacity - 1)];
+    tfrg_atomic32_store_release(&pRing->mTail, tail + 1);
+    return true;
+}
@@ -0,0 +1,170 @@
+# Copyright (c) 2017-2025 The Forge Interactive Inc.
+#
+# This file is part of The-Forge
+# (see https://github.com/ConfettiFX/The-Forge).
+#
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""
+Bakes the button-ID masks of 34_Input: one R8_UINT texel per texel of controller.tex and keyboard+mouse.tex that
+stores which button covers it, so basic.frag.fsl highlights with one fetch and one bit test per pixel.
+
+Button circles come from the tables in 34_Input.cpp (set, bit, ButtonLayout.h position and radius), e.g.:
+    python bake_button_ids.py --sample 34_Input --out <art>/Textures/input
+
+The output is DDS (DXGI_FORMAT_R8_UINT); convert it to .tex with the asset pipeline like the device textures.
+Texel value 0 means no button, otherwise value - 1 = set * 32 + bit index in gConstantData.buttonSet0..3.
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+# table in 34_Input.cpp, output name, resolution of the device texture it overlays (device.h.fsl)
+DEVICES = [
+    ('gGamepadButtons', 'controller_ids.dds', 512, 554),
+    ('gKeyboardMouseButtons', 'keyboard+mouse_ids.dds', 969, 264),
+]
+
+DXGI_FORMAT_R8_UINT = 62
+
+DEFINE_RE = re.compile(r'^#define\s+(\w+)\s+\(1u\s*<<\s*(\d+)\)')
+POS_RE = re.compile(r'^static constexpr ButtonPos\s+(\w+)\s*=\s*(.+);')
+ROW_RE = re.compile(r'^\s*\{\s*&\w+\s*,\s*(\d+)\s*,\s*(\w+)\s*,\s*(\w+)\s*,\s*([0-9.]+)f\s*\}')
+FLOAT_RE = re.compile(r'(\d+\.\d*|\.\d+|\d+)f\b')
+
+
+def parse_bits(path):
+    bits = {}
+    with open(path, 'r') as f:
+        for line in f:
+            match = DEFINE_RE.match(line.strip())
+            if match:
+                bits[match.group(1)] = int(match.group(2))
+    return bits
+
+
+def parse_layout(path):
+    positions = {}
+
+    def evaluate(expr):
+        expr = FLOAT_RE.sub(r'\1', expr)
+        expr = re.sub(r'\b(\w+)\.(x|y)\b', lambda m: repr(positions[m.group(1)][m.group(2) == 'y']), expr)
+        return float(eval(expr, {'__builtins__': {}}))
+
+    with open(path, 'r') as f:
+        for line in f:
+            match = POS_RE.match(line.strip())
+            if not match:
+                continue
+            value = match.group(2).strip()
+            if value.startswith('{'):
+                x, y = value.strip('{} ').split(',')
+                positions[match.group(1)] = (evaluate(x), evaluate(y))
+            else:
+                positions[match.group(1)] = positions[value]
+    return positions
+
+
+def parse_table(path, name):
+    with open(path, 'r') as f:
+        source = f.read()
+    start = source.find('ButtonBinding %s[] = {' % name)
+    if start < 0:
+        sys.exit('table %s not found in %s' % (name, path))
+    end = source.find('};', start)
+    rows = []
+    for line in source[start:end].splitlines()[1:]:
+        match = ROW_RE.match(line)
+        if match:
+            rows.append((int(match.group(1)), match.group(2), match.group(3), float(match.group(4))))
+    return rows
+
+
+def bake(buttons, width, height):
+    # Same space as the shader: v over the texture height, u scaled to keep circles round
+    aspect = width / float(height)
+    texels = bytearray(width * height)
+    for py in range(height):
+        v = (py + 0.5) / height
+        for px in range(width):
+            u = (px + 0.5) / width * aspect
+            best = 0
+            best_distance = None
+            for button_id, (x, y), radius in buttons:
+                distance = (u - x) * (u - x) + (v - y) * (v - y)
+                # A texel holds a single ID, overlapping circles go to the closest center
+                if distance < radius * radius and (best_distance is None or distance < best_distance):
+                    best = button_id
+                    best_distance = distance
+            texels[py * width + px] = best
+    return texels
+
+
+def write_dds(path, width, height, texels):
+    DDSD_CAPS, DDSD_HEIGHT, DDSD_WIDTH, DDSD_PITCH, DDSD_PIXELFORMAT = 0x1, 0x2, 0x4, 0x8, 0x1000
+    DDPF_FOURCC = 0x4
+    DDSCAPS_TEXTURE = 0x1000
+    D3D10_RESOURCE_DIMENSION_TEXTURE2D = 3
+
+    pixel_format = struct.pack('<II4s5I', 32, DDPF_FOURCC, b'DX10', 0, 0, 0, 0, 0)
+    header = struct.pack('<7I44x', 124, DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PITCH | DDSD_PIXELFORMAT, height,
+                         width, width, 0, 1)
+    header += pixel_format + struct.pack('<5I', DDSCAPS_TEXTURE, 0, 0, 0, 0)
+    dx10 = struct.pack('<5I', DXGI_FORMAT_R8_UINT, D3D10_RESOURCE_DIMENSION_TEXTURE2D, 0, 1, 0)
+
+    tmp_path = path + '.tmp'
+    with open(tmp_path, 'wb') as f:
+        f.write(b'DDS ')
+        f.write(header)
+        f.write(dx10)
+        f.write(texels)
+    os.replace(tmp_path, path)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Bake the 34_Input button-ID mask textures')
+    parser.add_argument('--sample', required=True, help='34_Input directory (34_Input.cpp, ButtonDefs.h, ButtonLayout.h)')
+    parser.add_argument('--out', required=True, help='output directory for the .dds masks')
+    args = parser.parse_args()
+
+    bits = parse_bits(os.path.join(args.sample, 'ButtonDefs.h'))
+    positions = parse_layout(os.path.join(args.sample, 'ButtonLayout.h'))
+    os.makedirs(args.out, exist_ok=True)
+
+    for table, file_name, width, height in DEVICES:
+        buttons = []
+        for button_set, bit, pos, radius in parse_table(os.path.join(args.sample, '34_Input.cpp'), table):
+            if bit not in bits or pos not in positions:
+                sys.exit('%s: unknown %s' % (table, bit if bit not in bits else pos))
+            buttons.append((1 + button_set * 32 + bits[bit], positions[pos], radius))
+
+        texels = bake(buttons, width, height)
+        covered = set(texels)
+        for button_id, pos, radius in buttons:
+            if button_id not in covered:
+                print('warning: %s button %d at (%.3f, %.3f) covers no texel' % (table, button_id, pos[0], pos[1]))
+
+        write_dds(os.path.join(args.out, file_name), width, height, texels)
+        print('baked %d buttons into %s (%dx%d)' % (len(buttons), file_name, width, height))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,126 @@
+# Copyright (c) 2017-2025 The Forge Interactive Inc.
+#
+# This file is part of The-Forge
+# (see https://github.com/ConfettiFX/The-Forge).
+#
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""
+Packs the FSL compiler output of one sample into a single <AppName>.shaderpak (see Shared/ShaderArchive.h).
+
+Run it after fsl.py, e.g.:
+    python pack_shaders.py --list 01_Transformations/Shaders/FSL/shaders.list \
+                           --binaries <bin>/Shaders/Vulkan/CompiledShaders \
+                           --out <bin>/Shaders/Vulkan/CompiledShaders/01_Transformations.shaderpak
+
+Every entry records the content hash of its compiled binary. On a shader reload the runtime hashes the loose
+binaries the reload server wrote and only uses an entry while it still matches, so the archive does not have to be
+re-packed after every recompile to stay correct, only to stay fast.
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+MAGIC = 0x4B505346  # "FSPK"
+VERSION = 2
+MAX_NAME = 64
+ALIGNMENT = 16
+
+STAGE_RE = re.compile(r'^#(vert|frag|comp|tesc|tese|geom)\b(.*)$')
+
+HEADER_FMT = '<IIII'
+ENTRY_FMT = '<QQII%ds' % MAX_NAME
+
+
+def name_hash(name):
+    # Must match shaderArchiveNameHash() in ShaderArchive.h
+    h = 14695981039346656037
+    for c in name.encode('utf-8'):
+        h = ((h ^ c) * 1099511628211) & 0xFFFFFFFFFFFFFFFF
+    return h
+
+
+def content_hash(data):
+    # Must match shaderArchiveContentHash() in ShaderArchive.h
+    h = 14695981039346656037
+    for c in data:
+        h = ((h ^ c) * 1099511628211) & 0xFFFFFFFFFFFFFFFF
+    return h
+
+
+def parse_list(list_path):
+    names = []
+    with open(list_path, 'r') as f:
+        for line in f:
+            match = STAGE_RE.match(line.strip())
+            if match:
+                # "#vert FT_MULTIVIEW basic.vert" -> feature tokens are compiled into derivatives of the same binary
+                names.append(match.group(2).split()[-1])
+    return names
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Pack compiled FSL shaders into a single archive')
+    parser.add_argument('--list', required=True, help='shaders.list of the sample')
+    parser.add_argument('--binaries', required=True, help='directory containing the fsl.py output')
+    parser.add_argument('--out', required=True, help='output .shaderpak path')
+    args = parser.parse_args()
+
+    records = []
+    for name in parse_list(args.list):
+        if len(name) >= MAX_NAME:
+            sys.exit('shader name too long: %s' % name)
+        binary_path = os.path.join(args.binaries, name)
+        if not os.path.exists(binary_path):
+            sys.exit('missing compiled shader: %s' % binary_path)
+        with open(binary_path, 'rb') as f:
+            blob = f.read()
+        records.append((name_hash(name), content_hash(blob), name, blob))
+
+    records.sort(key=lambda r: r[0])
+    for a, b in zip(records, records[1:]):
+        if a[0] == b[0]:
+            sys.exit('name hash collision: %s / %s' % (a[2], b[2]))
+
+    offset = struct.calcsize(HEADER_FMT) + len(records) * struct.calcsize(ENTRY_FMT)
+    blob_offsets = {}
+    blobs = bytearray()
+    table = bytearray()
+    for nhash, chash, name, blob in records:
+        if chash not in blob_offsets:
+            pad = (-(offset + len(blobs))) % ALIGNMENT
+            blobs += b'\0' * pad
+            blob_offsets[chash] = offset + len(blobs)
+            blobs += blob
+        table += struct.pack(ENTRY_FMT, nhash, chash, blob_offsets[chash], len(blob), name.encode('utf-8'))
+
+    tmp_path = args.out + '.tmp'
+    with open(tmp_path, 'wb') as f:
+        f.write(struct.pack(HEADER_FMT, MAGIC, VERSION, len(records), 0))
+        f.write(table)
+        f.write(blobs)
+    # Atomic swap so a running app never maps a half written archive
+    os.replace(tmp_path, args.out)
+    print('packed %d shaders (%d unique blobs) into %s' % (len(records), len(blob_offsets), args.out))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,300 @@
+/*
+ * Copyright (c) 2017-2025 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+// Chrome trace capture (chrome://tracing, ui.perfetto.dev) of CPU scopes and GPU ranges.
+// requestTraceCapture(n) records the next n frames: TRACE_SCOPE() ranges from any thread plus traceGpuBegin()/
+// traceGpuEnd() ranges of the graphics queue, and writes <AppName>_trace.json to RD_LOG once the last frame's
+// GPU timestamps are back.
+//
+// GPU timestamps go through a ring of query pools that is read back when a pool comes around again, so the
+// capture never waits on the GPU. GPU ticks are converted to microseconds and shifted onto the getUSec() clock
+// by the smallest offset that keeps every captured frame's GPU work after its queueSubmit(); that offset is
+// exact for frames where the queue was idle at submit time, which any capture of a few frames contains.
+
+#include "../../../../Common_3/Graphics/Interfaces/IGraphics.h"
+#include "../../../../Common_3/Utilities/Interfaces/IFileSystem.h"
+#include "../../../../Common_3/Utilities/Interfaces/ILog.h"
+#include "../../../../Common_3/Utilities/Interfaces/IThread.h"
+#include "../../../../Common_3/Utilities/Interfaces/ITime.h"
+#include "../../../../Common_3/Utilities/Threading/Atomics.h"
+
+#define TRACE_CAPTURE_MAX_EVENTS     (64 * 1024)
+#define TRACE_CAPTURE_MAX_GPU_RANGES 16
+#define TRACE_CAPTURE_MAX_GPU_DEPTH  8
+#define TRACE_CAPTURE_POOL_COUNT     4 // Must be larger than the number of frames in flight
+#define TRACE_CAPTURE_GPU_THREAD_ID  0xFFFFFFFFull
+
+struct TraceEvent
+{
+    const char* pName;
+    int64_t     mStart; // usec, GPU events stay on the GPU clock until the file is written
+    int64_t     mDuration;
+    uint64_t    mThreadId;
+};
+
+struct TraceGpuFrame
+{
+    const char* pRangeNames[TRACE_CAPTURE_MAX_GPU_RANGES];
+    uint32_t    mOpenRanges[TRACE_CAPTURE_MAX_GPU_DEPTH];
+    uint32_t    mRangeCount;
+    uint32_t    mOpenCount;
+    int64_t     mSubmitTime;
+    bool        mCapture;
+};
+
+struct TraceCapture
+{
+    Renderer*       pRenderer;
+    const char*     pAppName;
+    TraceEvent*     pEvents;
+    tfrg_atomic32_t mEventCount;
+    tfrg_atomic32_t mRecording;
+    uint64_t        mMainThreadId;
+    uint32_t        mFramesRequested;
+    uint32_t        mFramesLeft;
+    uint32_t        mGpuFramesPending;
+    uint32_t        mCapturedFrames;
+    double          mGpuTicksPerUSec;
+    int64_t         mGpuOffset;
+    bool            mGpuOffsetValid;
+    int64_t         mFrameStart;
+    uint32_t        mPoolIndex;
+    QueryPool*      pTimestampPools[TRACE_CAPTURE_POOL_COUNT];
+    TraceGpuFrame   mGpuFrames[TRACE_CAPTURE_POOL_COUNT];
+};
+
+static TraceCapture gTraceCapture = {};
+
+static inline void tracePushEvent(const char* pName, int64_t start, int64_t duration, uint64_t threadId)
+{
+    const uint32_t index = tfrg_atomic32_add_relaxed(&gTraceCapture.mEventCount, 1);
+    if (index < TRACE_CAPTURE_MAX_EVENTS)
+        gTraceCapture.pEvents[index] = { pName, start, duration, threadId };
+}
+
+// CPU range, free when no capture is running
+struct TraceScope
+{
+    const char* pName;
+    int64_t     mStart;
+
+    TraceScope(const char* pScopeName): pName(pScopeName), mStart(0)
+    {
+        if (tfrg_atomic32_load_acquire(&gTraceCapture.mRecording))
+            mStart = getUSec(true);
+    }
+
+    ~TraceScope()
+    {
+        if (mStart)
+            tracePushEvent(pName, mStart, getUSec(true) - mStart, (uint64_t)getCurrentThreadID());
+    }
+};
+
+#define TRACE_SCOPE_CONCAT_IMPL(a, b) a##b
+#define TRACE_SCOPE_CONCAT(a, b)      TRACE_SCOPE_CONCAT_IMPL(a, b)
+#define TRACE_SCOPE(name)             TraceScope TRACE_SCOPE_CONCAT(traceScope, __LINE__)(name)
+
+static inline void initTraceCapture(Renderer* pRenderer, Queue* pQueue, const char* appName)
+{
+    gTraceCapture = {};
+    gTraceCapture.pRenderer = pRenderer;
+    gTraceCapture.pAppName = appName;
+    gTraceCapture.mMainThreadId = (uint64_t)getCurrentThreadID();
+    gTraceCapture.pEvents = (TraceEvent*)tf_calloc(TRACE_CAPTURE_MAX_EVENTS, sizeof(TraceEvent));
+
+    double ticksPerSecond = 0.0;
+    getTimestampFrequency(pQueue, &ticksPerSecond);
+    gTraceCapture.mGpuTicksPerUSec = ticksPerSecond / 1e6;
+
+    QueryPoolDesc poolDesc = {};
+    poolDesc.mQueryCount = TRACE_CAPTURE_MAX_GPU_RANGES;
+    poolDesc.mType = QUERY_TYPE_TIMESTAMP;
+    for (uint32_t i = 0; i < TRACE_CAPTURE_POOL_COUNT; ++i)
+        initQueryPool(pRenderer, &poolDesc, &gTraceCapture.pTimestampPools[i]);
+}
+
+static inline void exitTraceCapture()
+{
+    for (uint32_t i = 0; i < TRACE_CAPTURE_POOL_COUNT; ++i)
+        exitQueryPool(gTraceCapture.pRenderer, gTraceCapture.pTimestampPools[i]);
+    tf_free(gTraceCapture.pEvents);
+    gTraceCapture = {};
+}
+
+static inline void requestTraceCapture(uint32_t frameCount)
+{
+    // Ignored while a capture is still being recorded or waiting for its GPU timestamps
+    if (!gTraceCapture.mFramesLeft && !gTraceCapture.mGpuFramesPending)
+        gTraceCapture.mFramesRequested = frameCount ? frameCount : 1;
+}
+
+// True while a capture is requested, recording or waiting for GPU timestamps, all of which need frames to be drawn
+static inline bool traceCaptureIsBusy()
+{
+    return gTraceCapture.mFramesRequested || gTraceCapture.mFramesLeft || gTraceCapture.mGpuFramesPending;
+}
+
+static inline void writeTraceCapture()
+{
+    char fileName[FS_MAX_PATH] = {};
+    snprintf(fileName, sizeof(fileName), "%s_trace.json", gTraceCapture.pAppName);
+    FileStream stream = {};
+    if (!fsOpenStreamFromPath(RD_LOG, fileName, FM_WRITE, &stream))
+    {
+        LOGF(LogLevel::eERROR, "Could not open %s for writing", fileName);
+        return;
+    }
+
+    fsPrintToStream(&stream, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fsPrintToStream(&stream, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%llu,\"args\":{\"name\":\"Main Thread\"}},\n",
+                    (unsigned long long)gTraceCapture.mMainThreadId);
+    fsPrintToStream(&stream, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%llu,\"args\":{\"name\":\"GPU Graphics Queue\"}}",
+                    (unsigned long long)TRACE_CAPTURE_GPU_THREAD_ID);
+
+    uint32_t eventCount = tfrg_atomic32_load_acquire(&gTraceCapture.mEventCount);
+    if (eventCount > TRACE_CAPTURE_MAX_EVENTS)
+        eventCount = TRACE_CAPTURE_MAX_EVENTS;
+    for (uint32_t i = 0; i < eventCount; ++i)
+    {
+        const TraceEvent& event = gTraceCapture.pEvents[i];
+        if (!event.pName)
+            continue;
+        const bool    gpu = event.mThreadId == TRACE_CAPTURE_GPU_THREAD_ID;
+        const int64_t start = gpu ? event.mStart + gTraceCapture.mGpuOffset : event.mStart;
+        fsPrintToStream(&stream, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%llu,\"ts\":%lld,\"dur\":%lld}", event.pName,
+                        gpu ? "gpu" : "cpu", (unsigned long long)event.mThreadId, (long long)start, (long long)event.mDuration);
+    }
+    fsPrintToStream(&stream, "\n]}\n");
+    fsCloseStream(&stream);
+
+    LOGF(LogLevel::eINFO, "Trace capture: %u frames, %u events written to %s%s", gTraceCapture.mCapturedFrames, eventCount, fileName,
+         eventCount == TRACE_CAPTURE_MAX_EVENTS ? " (event buffer full)" : "");
+}
+
+static inline void readTraceGpuFrame(TraceGpuFrame* pFrame, QueryPool* pPool)
+{
+    for (uint32_t i = 0; i < pFrame->mRangeCount; ++i)
+    {
+        QueryData data = {};
+        getQueryData(gTraceCapture.pRenderer, pPool, i, &data);
+        if (!data.mValid)
+            continue;
+
+        const int64_t begin = (int64_t)(data.mBeginTimestamp / gTraceCapture.mGpuTicksPerUSec);
+        const int64_t end = (int64_t)(data.mEndTimestamp / gTraceCapture.mGpuTicksPerUSec);
+        // Range 0 is the first one recorded, its start can not be earlier than the submit
+        if (i == 0)
+        {
+            const int64_t offset = pFrame->mSubmitTime - begin;
+            if (!gTraceCapture.mGpuOffsetValid || offset > gTraceCapture.mGpuOffset)
+                gTraceCapture.mGpuOffset = offset;
+            gTraceCapture.mGpuOffsetValid = true;
+        }
+        tracePushEvent(pFrame->pRangeNames[i], begin, end - begin, TRACE_CAPTURE_GPU_THREAD_ID);
+    }
+}
+
+// Call after the frame fence wait, with the frame's command buffer begun
+static inline void traceCaptureBeginFrame(Cmd* pCmd)
+{
+    TraceGpuFrame* pFrame = &gTraceCapture.mGpuFrames[gTraceCapture.mPoolIndex];
+    QueryPool*     pPool = gTraceCapture.pTimestampPools[gTraceCapture.mPoolIndex];
+    if (pFrame->mCapture)
+    {
+        readTraceGpuFrame(pFrame, pPool);
+        pFrame->mCapture = false;
+        if (--gTraceCapture.mGpuFramesPending == 0 && !gTraceCapture.mFramesLeft)
+            writeTraceCapture();
+    }
+
+    if (gTraceCapture.mFramesRequested && !gTraceCapture.mGpuFramesPending)
+    {
+        memset(gTraceCapture.pEvents, 0, TRACE_CAPTURE_MAX_EVENTS * sizeof(TraceEvent));
+        tfrg_atomic32_store_relaxed(&gTraceCapture.mEventCount, 0);
+        gTraceCapture.mFramesLeft = gTraceCapture.mFramesRequested;
+        gTraceCapture.mCapturedFrames = gTraceCapture.mFramesRequested;
+        gTraceCapture.mFramesRequested = 0;
+        gTraceCapture.mGpuOffsetValid = false;
+        tfrg_atomic32_store_release(&gTraceCapture.mRecording, 1);
+    }
+
+    pFrame->mRangeCount = 0;
+    pFrame->mOpenCount = 0;
+    pFrame->mCapture = gTraceCapture.mFramesLeft > 0;
+    if (pFrame->mCapture)
+    {
+        gTraceCapture.mFrameStart = getUSec(true);
+        ++gTraceCapture.mGpuFramesPending;
+        cmdResetQuery(pCmd, pPool, 0, TRACE_CAPTURE_MAX_GPU_RANGES);
+    }
+}
+
+static inline void traceGpuBegin(Cmd* pCmd, const char* pName)
+{
+    TraceGpuFrame* pFrame = &gTraceCapture.mGpuFrames[gTraceCapture.mPoolIndex];
+    if (!pFrame->mCapture || pFrame->mRangeCount == TRACE_CAPTURE_MAX_GPU_RANGES || pFrame->mOpenCount == TRACE_CAPTURE_MAX_GPU_DEPTH)
+        return;
+
+    const uint32_t index = pFrame->mRangeCount++;
+    pFrame->pRangeNames[index] = pName;
+    pFrame->mOpenRanges[pFrame->mOpenCount++] = index;
+    QueryDesc queryDesc = { index };
+    cmdBeginQuery(pCmd, gTraceCapture.pTimestampPools[gTraceCapture.mPoolIndex], &queryDesc);
+}
+
+static inline void traceGpuEnd(Cmd* pCmd)
+{
+    TraceGpuFrame* pFrame = &gTraceCapture.mGpuFrames[gTraceCapture.mPoolIndex];
+    if (!pFrame->mCapture || !pFrame->mOpenCount)
+        return;
+
+    QueryDesc queryDesc = { pFrame->mOpenRanges[--pFrame->mOpenCount] };
+    cmdEndQuery(pCmd, gTraceCapture.pTimestampPools[gTraceCapture.mPoolIndex], &queryDesc);
+}
+
+// Call before endCmd()
+static inline void traceCaptureEndFrame(Cmd* pCmd)
+{
+    TraceGpuFrame* pFrame = &gTraceCapture.mGpuFrames[gTraceCapture.mPoolIndex];
+    if (pFrame->mCapture && pFrame->mRangeCount)
+        cmdResolveQuery(pCmd, gTraceCapture.pTimestampPools[gTraceCapture.mPoolIndex], 0, pFrame->mRangeCount);
+}
+
+// Call right before queueSubmit()
+static inline void traceCaptureSubmit()
+{
+    TraceGpuFrame* pFrame = &gTraceCapture.mGpuFrames[gTraceCapture.mPoolIndex];
+    if (pFrame->mCapture)
+    {
+        pFrame->mSubmitTime = getUSec(true);
+        tracePushEvent("Frame", gTraceCapture.mFrameStart, pFrame->mSubmitTime - gTraceCapture.mFrameStart, gTraceCapture.mMainThreadId);
+        // CPU scopes stop with the last captured frame, its GPU ranges arrive TRACE_CAPTURE_POOL_COUNT frames later
+        if (--gTraceCapture.mFramesLeft == 0)
+            tfrg_atomic32_store_release(&gTraceCapture.mRecording, 0);
+    }
+    gTraceCapture.mPoolIndex = (gTraceCapture.mPoolIndex + 1) % TRACE_CAPTURE_POOL_COUNT;
+}